@@ -26,14 +26,14 @@ static Class *CL_EVENT_MOUSE_DOWN;
 static Class *CL_EVENT_MOUSE_UP;
 static Class *CL_EVENT_TIMER;
 
-#define display(c) (*(ALLEGRO_DISPLAY **)(c)->value)
-#define bitmap(c) (*(ALLEGRO_BITMAP **)(c)->value)
-#define font(c) (*(ALLEGRO_FONT **)(c)->value)
-#define color(c) (*(ALLEGRO_COLOR *)(c)->value)
-#define eventQueue(c) (*(ALLEGRO_EVENT_QUEUE **)(c)->value)
-#define event(c) (*(ALLEGRO_EVENT *)(c)->value)
-#define sample(c) (*(ALLEGRO_SAMPLE **)(c)->value)
-#define timer(c) (*(ALLEGRO_TIMER **)(c)->value)
+#define display(c) (*(ALLEGRO_DISPLAY **)objectValue(c))
+#define bitmap(c) (*(ALLEGRO_BITMAP **)objectValue(c))
+#define font(c) (*(ALLEGRO_FONT **)objectValue(c))
+#define color(c) (*(ALLEGRO_COLOR *)objectValue(c))
+#define eventQueue(c) (*(ALLEGRO_EVENT_QUEUE **)objectValue(c))
+#define event(c) (*(ALLEGRO_EVENT *)objectValue(c))
+#define sample(c) (*(ALLEGRO_SAMPLE **)objectValue(c))
+#define timer(c) (*(ALLEGRO_TIMER **)objectValue(c))
 
 PackageVersion getVersion() {
     return (PackageVersion){0, 1};
@@ -112,7 +112,7 @@ Something appDrawFilledTriangle(Thread *thread) {
 }
 
 Something displaySetTitle(Thread *thread) {
-    char *title = stringToChar(stackGetVariable(0, thread).object->value);
+    char *title = stringToChar(objectValue(stackGetVariable(0, thread).object));
     al_set_window_title(display(stackGetThisObject(thread)), title);
     free(title);
     return NOTHINGNESS;
@@ -206,7 +206,7 @@ Something appDrawScaledBitmap(Thread *thread) {
 
 Something appDrawText(Thread *thread) {
     ALLEGRO_FONT *font = font(stackGetVariable(0, thread).object);
-    char *text = stringToChar(stackGetVariable(4, thread).object->value);
+    char *text = stringToChar(objectValue(stackGetVariable(4, thread).object));
     float x = (float)stackGetVariable(2, thread).doubl;
     float y = (float)stackGetVariable(3, thread).doubl;
     al_draw_text(font, color(stackGetVariable(1, thread).object), x, y, (int)stackGetVariable(5, thread).raw, text);
@@ -235,13 +235,13 @@ void colorInitRGBA(Thread *thread) {
 }
 
 void bitmapInitFile(Thread *thread) {
-    char *path = stringToChar(stackGetVariable(0, thread).object->value);
+    char *path = stringToChar(objectValue(stackGetVariable(0, thread).object));
     ALLEGRO_BITMAP *bmp = al_load_bitmap(path);
     if (bmp) {
         bitmap(stackGetThisObject(thread)) = bmp;
     }
     else {
-        stackGetThisObject(thread)->value = NULL;
+        initializerFailed(thread);
     }
     free(path);
 }
@@ -256,18 +256,18 @@ void bitmapInitSize(Thread *thread) {
         bitmap(stackGetThisObject(thread)) = bmp;
     }
     else {
-        stackGetThisObject(thread)->value = NULL;
+        initializerFailed(thread);
     }
 }
 
 void fontInitFile(Thread *thread) {
-    char *path = stringToChar(stackGetVariable(0, thread).object->value);
+    char *path = stringToChar(objectValue(stackGetVariable(0, thread).object));
     ALLEGRO_FONT *font = al_load_ttf_font(path, (int)stackGetVariable(1, thread).raw, 0);
     if (font) {
         font(stackGetThisObject(thread)) = font;
     }
     else {
-        stackGetThisObject(thread)->value = NULL;
+        initializerFailed(thread);
     }
     free(path);
 }
@@ -286,7 +286,7 @@ void eventQueueDe(void *v) {
 
 Something eventQueueWait(Thread *thread) {
     Object *event = newObject(CL_EVENT);
-    al_wait_for_event(eventQueue(stackGetThisObject(thread)), event->value);
+    al_wait_for_event(eventQueue(stackGetThisObject(thread)), objectValue(event));
     switch (event(event).type) {
         case ALLEGRO_EVENT_KEY_CHAR:
             event->class = CL_EVENT_KEY_CHAR;
@@ -353,13 +353,13 @@ Something mouseAxesEventY(Thread *thread) {
 }
 
 void sampleInitFile(Thread *thread) {
-    char *path = stringToChar(stackGetVariable(0, thread).object->value);
+    char *path = stringToChar(objectValue(stackGetVariable(0, thread).object));
     ALLEGRO_SAMPLE *sample = al_load_sample(path);
     if (sample) {
         sample(stackGetThisObject(thread)) = sample;
     }
     else {
-        stackGetThisObject(thread)->value = NULL;
+        initializerFailed(thread);
     }
     free(path);
 }
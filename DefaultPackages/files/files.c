@@ -26,53 +26,64 @@ if((failureCondition))\
 
 
 //MARK: files
+
+//The natives below allow the GC while they wait for the file system. Paths are converted to C strings beforehand
+//and the bytes of a 📇 are copied through a buffer on the native stack, as the GC may move any object meanwhile.
+
 Something filesMkdir(Thread *thread){
-    int state = mkdir(stringToChar(stackGetVariable(0, thread).object->value), 0755);
+    char *s = stringToChar(objectValue(stackGetVariable(0, thread).object));
+    allowGC();
+    int state = mkdir(s, 0755);
+    disallowGCAndPauseIfNeeded();
+    free(s);
     
     handleNEP(state != 0);
     return NOTHINGNESS;
 }
 
 Something filesSymlink(Thread *thread){
-    char *s = stringToChar(stackGetVariable(0, thread).object->value);
-    int state = symlink(s, stringToChar(stackGetVariable(1, thread).object->value));
+    char *s = stringToChar(objectValue(stackGetVariable(0, thread).object));
+    char *d = stringToChar(objectValue(stackGetVariable(1, thread).object));
+    allowGC();
+    int state = symlink(s, d);
+    disallowGCAndPauseIfNeeded();
     free(s);
+    free(d);
     
     handleNEP(state != 0);
     return NOTHINGNESS;
 }
 
-Something filesFileExists(Thread *thread){
-    char *s = stringToChar(stackGetVariable(0, thread).object->value);
-    Something x = (access(s, F_OK) == 0) ? EMOJICODE_TRUE : EMOJICODE_FALSE;
+static Something filesAccess(int mode, Thread *thread){
+    char *s = stringToChar(objectValue(stackGetVariable(0, thread).object));
+    allowGC();
+    Something x = (access(s, mode) == 0) ? EMOJICODE_TRUE : EMOJICODE_FALSE;
+    disallowGCAndPauseIfNeeded();
     free(s);
     return x;
 }
 
+Something filesFileExists(Thread *thread){
+    return filesAccess(F_OK, thread);
+}
+
 Something filesIsReadable(Thread *thread){
-    char *s = stringToChar(stackGetVariable(0, thread).object->value);
-    Something x = (access(s, R_OK) == 0) ? EMOJICODE_TRUE : EMOJICODE_FALSE;
-    free(s);
-    return x;
+    return filesAccess(R_OK, thread);
 }
 
 Something filesIsWriteable(Thread *thread){
-    char *s = stringToChar(stackGetVariable(0, thread).object->value);
-    Something x = (access(s, W_OK) == 0)  ? EMOJICODE_TRUE : EMOJICODE_FALSE;
-    free(s);
-    return x;
+    return filesAccess(W_OK, thread);
 }
 
 Something filesIsExecuteable(Thread *thread){
-    char *s = stringToChar(stackGetVariable(0, thread).object->value);
-    Something x = (access(s, X_OK) == 0)  ? EMOJICODE_TRUE : EMOJICODE_FALSE;
-    free(s);
-    return x;
+    return filesAccess(X_OK, thread);
 }
 
 Something filesRemove(Thread *thread){
-    char *s = stringToChar(stackGetVariable(0, thread).object->value);
+    char *s = stringToChar(objectValue(stackGetVariable(0, thread).object));
+    allowGC();
     int state = remove(s);
+    disallowGCAndPauseIfNeeded();
     free(s);
     
     handleNEP(state != 0);
@@ -80,8 +91,10 @@ Something filesRemove(Thread *thread){
 }
 
 Something filesRmdir(Thread *thread){
-    char *s = stringToChar(stackGetVariable(0, thread).object->value);
+    char *s = stringToChar(objectValue(stackGetVariable(0, thread).object));
+    allowGC();
     int state = rmdir(s);
+    disallowGCAndPauseIfNeeded();
     free(s);
     
     handleNEP(state != 0);
@@ -105,38 +118,40 @@ int filesRecursiveRmdirHelper(const char *fpath, const struct stat *sb, int type
 }
 
 Something filesRecursiveRmdir(Thread *thread){
-    char *s = stringToChar(stackGetVariable(0, thread).object->value);
+    char *s = stringToChar(objectValue(stackGetVariable(0, thread).object));
     
+    allowGC();
     int state = nftw(s, filesRecursiveRmdirHelper, 64, FTW_DEPTH | FTW_PHYS);
-    handleNEP(state != 0);
-    
+    disallowGCAndPauseIfNeeded();
     free(s);
+    
+    handleNEP(state != 0);
     return NOTHINGNESS;
 }
 
 Something filesSize(Thread *thread){
-    char *s = stringToChar(stackGetVariable(0, thread).object->value);
+    char *s = stringToChar(objectValue(stackGetVariable(0, thread).object));
     
+    allowGC();
     FILE *file = fopen(s, "r");
-    free(s);
-    
-    if(file == NULL){
-        return somethingInteger(-1);
+    long length = -1;
+    if (file) {
+        fseek(file, 0L, SEEK_END);
+        length = ftell(file);
+        fclose(file);
     }
-    
-    fseek(file, 0L, SEEK_END);
-    
-    long length = ftell(file);
-    
-    fclose(file);
+    disallowGCAndPauseIfNeeded();
+    free(s);
     
     return somethingInteger((EmojicodeInteger)length);
 }
 
 Something filesRealpath(Thread *thread) {
     char path[PATH_MAX];
-    char *s = stringToChar(stackGetVariable(0, thread).object->value);
+    char *s = stringToChar(objectValue(stackGetVariable(0, thread).object));
+    allowGC();
     char *x = realpath(s, path);
+    disallowGCAndPauseIfNeeded();
     
     free(s);
     
@@ -148,62 +163,107 @@ Something filesRealpath(Thread *thread) {
 
 //MARK: file
 
+/** Bytes in the heap are copied through a native buffer of this size, larger writes from pinnable arrays are not. */
+#define ioChunkSize 16384
+
+/** Writes the bytes of the 📇 in variable @c index to @c file. Returns false if not all bytes could be written. */
+static bool writeDataVariable(FILE *file, uint8_t index, Thread *thread){
+    Data *d = objectValue(stackGetVariable(index, thread).object);
+    size_t length = d->length, written;
+    
+    if (d->bytesObject->class == CL_DATA_BUFFER) {
+        //The bytes are outside the heap and the 📇 on the stack keeps them alive
+        char *bytes = d->bytes;
+        allowGC();
+        written = fwrite(bytes, 1, length, file);
+        disallowGCAndPauseIfNeeded();
+        return written == length;
+    }
+    
+    if (length > ioChunkSize && pinArray(d->bytesObject)) {
+        Object *bytesObject = d->bytesObject;
+        char *bytes = d->bytes;
+        allowGC();
+        written = fwrite(bytes, 1, length, file);
+        disallowGCAndPauseIfNeeded();
+        unpinArray(bytesObject);
+        return written == length;
+    }
+    
+    //The bytes are in the heap, which the GC may compact while it is allowed, and are copied in chunks
+    char chunk[ioChunkSize];
+    for (size_t offset = 0; offset < length; offset += ioChunkSize) {
+        size_t chunkLength = length - offset < ioChunkSize ? length - offset : ioChunkSize;
+        d = objectValue(stackGetVariable(index, thread).object);
+        memcpy(chunk, d->bytes + offset, chunkLength);
+        allowGC();
+        written = fwrite(chunk, 1, chunkLength, file);
+        disallowGCAndPauseIfNeeded();
+        if (written != chunkLength) {
+            return false;
+        }
+    }
+    return true;
+}
+
 //Shortcuts
 
 Something fileDataPut(Thread *thread){
-    char *s = stringToChar(stackGetVariable(0, thread).object->value);
+    char *s = stringToChar(objectValue(stackGetVariable(0, thread).object));
+    allowGC();
     FILE *file = fopen(s, "wb");
+    disallowGCAndPauseIfNeeded();
     free(s);
     
     handleNEP(file == NULL);
     
-    Data *d = stackGetVariable(1, thread).object->value;
-    
-    fwrite(d->bytes, 1, d->length, file);
+    bool written = writeDataVariable(file, 1, thread);
     
-    handleNEP(ferror(file));
+    allowGC();
+    int state = fclose(file);
+    disallowGCAndPauseIfNeeded();
     
-    fclose(file);
+    handleNEP(!written || state != 0);
     return NOTHINGNESS;
 }
 
 Something fileDataGet(Thread *thread){
-    char *s = stringToChar(stackGetVariable(0, thread).object->value);
+    char *s = stringToChar(objectValue(stackGetVariable(0, thread).object));
+    allowGC();
     FILE *file = fopen(s, "rb");
+    long length = -1;
+    if (file) {
+        fseek(file, 0, SEEK_END);
+        length = ftell(file);
+        fseek(file, 0, SEEK_SET);
+    }
+    disallowGCAndPauseIfNeeded();
     free(s);
     
     if(file == NULL){
         return NOTHINGNESS;
     }
-    
-    int state = fseek(file, 0, SEEK_END);
-    
-    long length = ftell(file);
-    
-    state = fseek(file, 0, SEEK_SET);
-    
-    Object *bytesObject = newArray(length);
-    fread(bytesObject->value, 1, length, file);
-    if(ferror(file)){
+    char *bytes = length >= 0 ? malloc(length > 0 ? length : 1) : NULL;
+    if (!bytes) {
         fclose(file);
         return NOTHINGNESS;
     }
-    fclose(file);
-    
-    stackPush(somethingObject(bytesObject), 0, 0, thread);
     
-    Object *obj = newObject(CL_DATA);
-    Data *data = obj->value;
-    data->length = length;
-    data->bytesObject = stackGetThisObject(thread);
-    data->bytes = data->bytesObject->value;
+    allowGC();
+    size_t read = fread(bytes, 1, length, file);
+    bool failed = ferror(file);
+    fclose(file);
+    disallowGCAndPauseIfNeeded();
     
-    stackPop(thread);
+    if(failed){
+        free(bytes);
+        return NOTHINGNESS;
+    }
     
-    return somethingObject(obj);
+    return somethingObject(newOffHeapData(bytes, read));
 }
 
-#define file(obj) (*((FILE**)(obj)->value))
+#define file(obj) (*((FILE**)objectValue(obj)))
 
 Something fileStdinGet(Thread *thread) {
     Object *obj = newObject(stackGetThisObjectClass(thread));
@@ -225,38 +285,39 @@ Something fileStderrGet(Thread *thread) {
 
 //Constructors
 
-void fileForWriting(Thread *thread){
-    char *p = stringToChar(stackGetVariable(0, thread).object->value);
-    FILE *f = fopen(p, "wb");
+static void fileOpen(const char *mode, Thread *thread){
+    char *p = stringToChar(objectValue(stackGetVariable(0, thread).object));
+    allowGC();
+    FILE *f = fopen(p, mode);
+    disallowGCAndPauseIfNeeded();
     if (f){
         file(stackGetThisObject(thread)) = f;
     }
     else {
-        stackGetThisObject(thread)->value = NULL;
+        initializerFailed(thread);
     }
     free(p);
 }
 
+void fileForWriting(Thread *thread){
+    fileOpen("wb", thread);
+}
+
 void fileForReading(Thread *thread){
-    char *p = stringToChar(stackGetVariable(0, thread).object->value);
-    FILE *f = fopen(p, "rb");
-    if (f){
-        file(stackGetThisObject(thread)) = f;
-    }
-    else {
-        stackGetThisObject(thread)->value = NULL;
-    }
-    free(p);
+    fileOpen("rb", thread);
 }
 
 Something fileWriteData(Thread *thread){
     FILE *f = file(stackGetThisObject(thread));
-    Data *d = stackGetVariable(0, thread).object->value;
+    coroutineWaitForFileDescriptor(fileno(f), true);
     
-    fwrite(d->bytes, 1, d->length, f);
+    bool written = writeDataVariable(f, 0, thread);
+    allowGC();
     fflush(f);
+    bool failed = ferror(f);
+    disallowGCAndPauseIfNeeded();
     
-    handleNEP(ferror(f));
+    handleNEP(!written || failed);
     return NOTHINGNESS;
 }
 
@@ -264,34 +325,39 @@ Something fileReadData(Thread *thread){
     FILE *f = file(stackGetThisObject(thread));
     EmojicodeInteger n = unwrapInteger(stackGetVariable(0, thread));
     
-    Object *bytesObject = newArray(n);
-    
-    size_t read = fread(bytesObject->value, 1, n, f);
-    
-    if(read != n || ferror(f)){
+    char *bytes = n >= 0 ? malloc(n > 0 ? n : 1) : NULL;
+    if (!bytes) {
         return NOTHINGNESS;
     }
     
-    stackPush(somethingObject(bytesObject), 0, 0, thread);
+    allowGC();
+    size_t read = fread(bytes, 1, n, f);
+    bool failed = ferror(f);
+    disallowGCAndPauseIfNeeded();
     
-    Object *obj = newObject(CL_DATA);
-    Data *data = obj->value;
-    data->length = n;
-    data->bytesObject = stackGetThisObject(thread);
-    data->bytes = data->bytesObject->value;
-    
-    stackPop(thread);
+    if(read != n || failed){
+        free(bytes);
+        return NOTHINGNESS;
+    }
     
-    return somethingObject(obj);
+    return somethingObject(newOffHeapData(bytes, n));
 }
 
 Something fileSeekTo(Thread *thread){
-    fseek(file(stackGetThisObject(thread)), unwrapInteger(stackGetVariable(0, thread)), SEEK_SET);
+    FILE *f = file(stackGetThisObject(thread));
+    EmojicodeInteger offset = unwrapInteger(stackGetVariable(0, thread));
+    //Seeking writes buffered data
+    allowGC();
+    fseek(f, offset, SEEK_SET);
+    disallowGCAndPauseIfNeeded();
     return NOTHINGNESS;
 }
 
 Something fileSeekToEnd(Thread *thread){
-    fseek(file(stackGetThisObject(thread)), 0, SEEK_END);
+    FILE *f = file(stackGetThisObject(thread));
+    allowGC();
+    fseek(f, 0, SEEK_END);
+    disallowGCAndPauseIfNeeded();
     return NOTHINGNESS;
 }
 
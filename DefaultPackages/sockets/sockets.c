@@ -13,6 +13,9 @@
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
 
 static Class *CL_SOCKET;
 
@@ -20,10 +23,23 @@ PackageVersion getVersion() {
     return (PackageVersion){0, 1};
 }
 
+/**
+ * Waits until the socket is ready for reading or writing. The GC may run meanwhile and a coroutine lets its carrier
+ * run other coroutines.
+ */
+static void waitForSocket(int socketDescriptor, bool writing) {
+    if (!coroutineWaitForFileDescriptor(socketDescriptor, writing)) {
+        struct pollfd descriptor = {.fd = socketDescriptor, .events = writing ? POLLOUT : POLLIN};
+        allowGC();
+        poll(&descriptor, 1, -1);
+        disallowGCAndPauseIfNeeded();
+    }
+}
+
 void serverInitWithPort(Thread *thread) {
     int listenerDescriptor = socket(PF_INET, SOCK_STREAM, 0);
     if (listenerDescriptor == -1) {
-        stackGetThisObject(thread)->value = NULL;
+        initializerFailed(thread);
         return;
     }
     
@@ -36,90 +52,139 @@ void serverInitWithPort(Thread *thread) {
     if (setsockopt(listenerDescriptor, SOL_SOCKET, SO_REUSEADDR, (char *)&reuse, sizeof(int)) == -1 ||
         bind(listenerDescriptor, (struct sockaddr *)&name, sizeof(name)) == -1 ||
         listen(listenerDescriptor, 10) == -1) {
-        stackGetThisObject(thread)->value = NULL;
+        initializerFailed(thread);
         return;
     }
     
-    *(int *)stackGetThisObject(thread)->value = listenerDescriptor;
+    *(int *)objectValue(stackGetThisObject(thread)) = listenerDescriptor;
 }
 
 Something serverAccept(Thread *thread) {
-    int listenerDescriptor = *(int *)stackGetThisObject(thread)->value;
+    int listenerDescriptor = *(int *)objectValue(stackGetThisObject(thread));
+    coroutineWaitForFileDescriptor(listenerDescriptor, false);
     struct sockaddr_storage clientAddress;
     unsigned int addressSize = sizeof(clientAddress);
+    allowGC();
     int connectionAddress = accept(listenerDescriptor, (struct sockaddr *)&clientAddress, &addressSize);
+    disallowGCAndPauseIfNeeded();
     
     if (connectionAddress == -1) {
         return NOTHINGNESS;
     }
     
     Object *socket = newObject(CL_SOCKET);
-    *(int *)socket->value = connectionAddress;
+    *(int *)objectValue(socket) = connectionAddress;
     return somethingObject(socket);
 }
 
 Something socketSendData(Thread *thread) {
-    int connectionAddress = *(int *)stackGetThisObject(thread)->value;
-    Data *data = stackGetVariable(0, thread).object->value;
-    if (send(connectionAddress, data->bytes, data->length, 0) == -1) {
-        return EMOJICODE_FALSE;
+    int connectionAddress = *(int *)objectValue(stackGetThisObject(thread));
+    //The bytes are only sent without blocking, as the GC may move them while the thread waits
+    for (size_t offset = 0;;) {
+        Data *data = objectValue(stackGetVariable(0, thread).object);
+        if (offset >= (size_t)data->length) {
+            return EMOJICODE_TRUE;
+        }
+        ssize_t sent = send(connectionAddress, data->bytes + offset, data->length - offset, MSG_DONTWAIT);
+        if (sent > 0) {
+            offset += sent;
+        }
+        else if (sent == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            waitForSocket(connectionAddress, true);
+        }
+        else {
+            return EMOJICODE_FALSE;
+        }
     }
-    return EMOJICODE_TRUE;
 }
 
 Something socketClose(Thread *thread) {
-    int connectionAddress = *(int *)stackGetThisObject(thread)->value;
+    int connectionAddress = *(int *)objectValue(stackGetThisObject(thread));
+    allowGC();
     close(connectionAddress);
+    disallowGCAndPauseIfNeeded();
     return NOTHINGNESS;
 }
 
 Something socketReadBytes(Thread *thread) {
-    int connectionAddress = *(int *)stackGetThisObject(thread)->value;
+    int connectionAddress = *(int *)objectValue(stackGetThisObject(thread));
     EmojicodeInteger n = unwrapInteger(stackGetVariable(0, thread));
     
-    Object *bytesObject = newArray(n);
-    
-    size_t read = recv(connectionAddress, bytesObject->value, n, 0);
-    
-    if (read < 1) {
+    if (n < 0) {
         return NOTHINGNESS;
     }
     
-    stackPush(somethingObject(bytesObject), 0, 0, thread);
+    //The bytes are received outside the heap and become the bytes of the 📇
+    char *bytes = malloc(n > 0 ? n : 1);
+    if (!bytes) {
+        return NOTHINGNESS;
+    }
     
-    Object *obj = newObject(CL_DATA);
-    Data *data = obj->value;
-    data->length = read;
-    data->bytesObject = stackGetThisObject(thread);
-    data->bytes = data->bytesObject->value;
+    ssize_t read;
+    while ((read = recv(connectionAddress, bytes, n, MSG_DONTWAIT)) == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        waitForSocket(connectionAddress, false);
+    }
     
-    stackPop(thread);
-    return somethingObject(obj);
+    if (read < 1) {
+        free(bytes);
+        return NOTHINGNESS;
+    }
+    if (read < n) {
+        char *shrunk = realloc(bytes, read);
+        if (shrunk) {
+            bytes = shrunk;
+        }
+    }
+    return somethingObject(newOffHeapData(bytes, read));
+}
+
+/** Connects like @c connect but allows the GC and suspends the calling coroutine while it waits. */
+static int connectSocket(int socketDescriptor, const struct sockaddr *address, socklen_t addressLength) {
+    int flags = fcntl(socketDescriptor, F_GETFL);
+    if (flags == -1 || fcntl(socketDescriptor, F_SETFL, flags | O_NONBLOCK) == -1) {
+        allowGC();
+        int result = connect(socketDescriptor, address, addressLength);
+        disallowGCAndPauseIfNeeded();
+        return result;
+    }
+    int result = connect(socketDescriptor, address, addressLength);
+    if (result == -1 && errno == EINPROGRESS) {
+        waitForSocket(socketDescriptor, true);
+        int socketError;
+        socklen_t length = sizeof(socketError);
+        result = getsockopt(socketDescriptor, SOL_SOCKET, SO_ERROR, &socketError, &length) == 0 && socketError == 0
+                 ? 0 : -1;
+    }
+    fcntl(socketDescriptor, F_SETFL, flags);
+    return result;
 }
 
 void socketInitWithHost(Thread *thread) {
-    char *string = stringToChar(stackGetVariable(0, thread).object->value);
-    char *service = stringToChar(stackGetVariable(1, thread).object->value);
+    char *string = stringToChar(objectValue(stackGetVariable(0, thread).object));
+    char *service = stringToChar(objectValue(stackGetVariable(1, thread).object));
     
     struct addrinfo *res;
     struct addrinfo hints;
     memset(&hints, 0, sizeof(hints));
     hints.ai_family = PF_UNSPEC;
     hints.ai_socktype = SOCK_STREAM;
-    if (getaddrinfo(string, service, &hints, &res) == -1) {
-        stackGetThisObject(thread)->value = NULL;
-        return;
-    }
+    allowGC();
+    int status = getaddrinfo(string, service, &hints, &res);
+    disallowGCAndPauseIfNeeded();
     free(string);
     free(service);
+    if (status != 0) {
+        initializerFailed(thread);
+        return;
+    }
     int socketDescriptor = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
-    if (socketDescriptor == -1 || connect(socketDescriptor, res->ai_addr, res->ai_addrlen) == -1) {
+    if (socketDescriptor == -1 || connectSocket(socketDescriptor, res->ai_addr, res->ai_addrlen) == -1) {
         freeaddrinfo(res);
-        stackGetThisObject(thread)->value = NULL;
+        initializerFailed(thread);
         return;
     }
     freeaddrinfo(res);
-    *(int *)stackGetThisObject(thread)->value = socketDescriptor;
+    *(int *)objectValue(stackGetThisObject(thread)) = socketDescriptor;
 }
 
 void socketDestruct(void *d) {
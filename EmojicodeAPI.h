@@ -36,22 +36,28 @@ extern Class *CL_CAPTURED_FUNCTION_CALL;
 extern Class *CL_CLOSURE;
 extern Class *CL_RANGE;
 extern Class *CL_ARRAY;
+extern Class *CL_DATA_BUFFER;
 
+/**
+ * The object header. The value area directly follows the header and is followed by the instance variables.
+ *
+ * Packages written for earlier versions of this header used the @c value and @c newLocation fields, which were
+ * removed to halve the header size: Replace @c object->value with @c objectValue(object) and replace
+ * @c object->value = NULL in a failable initializer with @c initializerFailed(thread).
+ */
 typedef struct Object {
-    /** The object’s class. */
-    Class *class;
-    /** The size of this object: the size of the Object struct and the value area. */
-    size_t size;
-    /** The objects garabage collection state. Do not touch this field! */
-    struct Object *newLocation;
     /**
-     * A pointer to the allocated @c value area. This area is as large as specified in the class.
-     * @warning Never change the content of this variable as the Garbage Collector updates this field
-     * in each cycle.
+     * The object’s class.
+     * @warning While the Garbage Collector runs this word holds the object’s forwarding pointer.
      */
-    void *value;
+    Class *class;
+    /** The size of this object: the size of the Object struct, the value area and the instance variables. */
+    size_t size;
 } Object;
 
+/** Returns a pointer to the value area of @c object. This area is as large as specified in the class. */
+#define objectValue(object) ((void *)((Byte *)(object) + sizeof(Object)))
+
 #define T_OBJECT 0
 #define T_INTEGER 1
 #define T_BOOLEAN 2
@@ -62,7 +68,14 @@ typedef struct Object {
 typedef uint_fast8_t Type;
 typedef unsigned char Byte;
 
-/** Either an object reference or a primitive value. */
+/**
+ * Either an object reference or a primitive value.
+ *
+ * A @c Something occupies 16 bytes, as the type is padded to the alignment of the payload. This layout is used on the
+ * stack, in instance variables that are not unboxed, in dictionaries and by natives. There is no 8-byte tagged form:
+ * integers and doubles outside its range would have to be boxed, which would make arithmetic allocate. Lists, which
+ * hold the most values, store the payloads and the type bytes of their items in separate areas instead.
+ */
 typedef struct {
     /** The type of the primitive or whether it contains an object reference. */
     Type type;
@@ -111,9 +124,21 @@ typedef struct String {
 typedef struct {
     EmojicodeInteger length;
     char *bytes;
+    /**
+     * The array containing @c bytes or, if the bytes are stored outside the heap, an object of class
+     * @c CL_DATA_BUFFER that frees them when it is collected. Slices share it with the 📇 they were created from.
+     */
     Object *bytesObject;
 } Data;
 
+/**
+ * Creates a 📇 whose bytes are stored outside the heap and are thus never copied by the GC. The 📇 takes ownership of
+ * @c bytes, which must have been allocated with @c malloc, and frees them once neither it nor a slice of it is
+ * reachable anymore.
+ * @warning GC-invoking
+ */
+extern Object* newOffHeapData(char *bytes, EmojicodeInteger length);
+
 typedef struct {
     const char *message;
     EmojicodeInteger code;
@@ -139,12 +164,19 @@ extern Something executeCallableExtern(Object *callable, Something *args, Thread
 
 /**
  * Allocates a new object for the given class.
- * The @c value field will point to a value area as large as specified for the given class.
+ * @c objectValue will return a pointer to a value area as large as specified for the given class.
  * @param class The class of the object.
  * @warning GC-invoking
  */
 extern Object* newObject(Class *class);
 
+/**
+ * Signals that the native failable initializer running on @c thread failed. The initializer must return
+ * immediately afterwards and Nothingness is returned to the caller instead of the new object. The object’s
+ * deinitializer is not called.
+ */
+extern void initializerFailed(Thread *thread);
+
 /**
  * Multiplies @c items by @c itemSize and terminates the program with an error if an integer
  * overflow occured.
@@ -153,6 +185,8 @@ extern size_t sizeCalculationWithOverflowProtection(size_t items, size_t itemSiz
 
 /** 
  * Allocates an object with an value area with the size given.
+ * Large arrays are allocated outside the heap and are never moved by the GC, but you must not rely on this. Use
+ * @c newPinnedArray for arrays that must not move, @c pinArray tells whether an existing array can be pinned.
  * @param size The size of the value area.
  * @warning GC-invoking
  */
@@ -186,6 +220,21 @@ extern bool instanceof(Object *object, Class *cl);
  * @warning This function will modify @c P to point to an exact copy of @c O after the function call.
  */
 extern void mark(Object **of);
+/**
+ * Must be called with every object reference that is overwritten or removed from an object, or from a native
+ * structure the object’s class marker marks, before the reference is changed. @c NULL is ignored.
+ *
+ * The incremental collector relies on this to mark all objects that were reachable when its cycle started.
+ * References in new objects, on the stack or in local variables need not be passed.
+ */
+extern void writeBarrier(Object *overwritten);
+/** Like @c writeBarrier but for a @c Something, which is ignored if it does not contain an object. */
+extern void writeBarrierSomething(Something overwritten);
+/**
+ * Set while the incremental collector marks, which is the only time @c writeBarrier records references. Loops that
+ * only pass references to @c writeBarrier can be skipped if it is not set.
+ */
+extern bool incrementalMarking;
 /**
  * If the calling thread needs to be paused for the GC to run, this function will first
  * unlock @c mutex if it is not a @c NULL pointer, then block until the GC cycle is completed
@@ -208,6 +257,38 @@ extern void allowGC();
  */
 extern void disallowGCAndPauseIfNeeded();
 
+/**
+ * Pins the array, so that the GC neither moves nor frees it until @c unpinArray is called as often as it was
+ * pinned. The value area of a pinned array can thus be handed to a system call while the GC is allowed.
+ *
+ * Only arrays allocated outside the heap, like those returned by @c newPinnedArray, can be pinned. Arrays in the heap
+ * are moved by the GC and are left unpinned; copy their content in pieces instead.
+ * @returns Whether the array was pinned.
+ */
+extern bool pinArray(Object *array);
+/**
+ * Allocates an array like @c newArray that is allocated outside the heap and pinned.
+ * @warning GC-invoking
+ */
+extern Object* newPinnedArray(size_t size);
+/**
+ * Unpins an array pinned by @c pinArray or returned by @c newPinnedArray. Unless the array is referenced from somewhere else,
+ * it may be freed by the next GC cycle. You must not call this function while the GC is allowed.
+ */
+extern void unpinArray(Object *array);
+
+//MARK: Coroutines
+
+/**
+ * If the calling thread is a 🌀 coroutine, suspends it until @c fd is ready for reading or, if @c writing is true,
+ * for writing, so that its carrier thread runs other coroutines meanwhile. Call this function before a call that
+ * would block on @c fd.
+ * @returns Whether the coroutine waited. False is returned immediately if the calling thread is not a coroutine or if
+ * @c fd cannot be waited for, like regular files.
+ * @warning GC-invoking
+ */
+extern bool coroutineWaitForFileDescriptor(int fd, bool writing);
+
 //MARK: Stack
 
 /**
@@ -17,6 +17,7 @@ Scope& CallableScoper::currentScope() {
 void CallableScoper::popScopeAndRecommendFrozenVariables() {
     auto &scope = currentScope();
     scope.recommendFrozenVariables();
+    recordReferenceSlots(scope);
     nextVariableID_ -= scope.localVariableCount();
     scopes_.pop_front();
 }
@@ -64,6 +65,20 @@ int CallableScoper::reserveVariableSlot() {
     return id;
 }
 
+int CallableScoper::reserveReferenceSlot() {
+    auto id = reserveVariableSlot();
+    referenceSlots_.insert(id);
+    return id;
+}
+
+void CallableScoper::recordReferenceSlots(const Scope &scope) {
+    for (auto &it : scope.map_) {
+        if (it.second.type.mayHoldReference()) {
+            referenceSlots_.insert(it.second.id());
+        }
+    }
+}
+
 void CallableScoper::ensureNReservations(int n) {
     if (nextVariableID_ < n) {
         nextVariableID_ = n;
@@ -72,11 +87,13 @@ void CallableScoper::ensureNReservations(int n) {
 }
 
 std::pair<CallableScoper, int> CallableScoper::flattenedCopy(int argumentCount) const {
-    int variableCount = 0;
+    // Slots reserved for internal use, like the iterator of a list loop, have no name but still shift the IDs of
+    // the variables after them, so all slots up to the next free ID are captured
+    int variableCount = nextVariableID_;
     CallableScoper scoper = CallableScoper(objectScope());
     Scope &flattenedScope = scoper.pushScope();
     
-    scoper.nextVariableID_ += argumentCount;
+    scoper.nextVariableID_ += argumentCount + variableCount;
     
     for (auto &scope : scopes_) {
         for (auto &it : scope.map_) {
@@ -84,10 +101,10 @@ std::pair<CallableScoper, int> CallableScoper::flattenedCopy(int argumentCount)
                                      it.second.initialized, true, it.second.definitionToken);
             flattenedScope.setLocalVariable(it.first, variable);
         }
-        scoper.nextVariableID_ += scope.map_.size();
-        variableCount += scope.map_.size();
     }
     scoper.syncMaxVariableCount();
+    // The flattened scope is never popped, the captured variables must be recorded now
+    scoper.recordReferenceSlots(flattenedScope);
     
     return std::pair<CallableScoper, int>(scoper, variableCount);
 }
\ No newline at end of file
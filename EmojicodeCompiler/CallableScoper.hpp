@@ -10,6 +10,7 @@
 #define CallableScoper_hpp
 
 #include <forward_list>
+#include <set>
 #include <utility>
 #include "EmojicodeCompiler.hpp"
 #include "Scope.hpp"
@@ -55,6 +56,8 @@ public:
     
     /** Reserves an variable slot and returns the Variable ID. */
     int reserveVariableSlot();
+    /** Reserves a variable slot for an internal value that may be an object reference and returns its ID. */
+    int reserveReferenceSlot();
     
     /** Ensures that at least @c n slots are reserved. */
     void ensureNReservations(int n);
@@ -65,13 +68,22 @@ public:
      *          is therefore not always equal to the variables in a scope.
      */
     int maxVariableCount() { return maxVariableCount_; };
+    
+    /**
+     * Returns the IDs of all slots that may contain an object reference at some point. This is the callable’s stack
+     * map. Only complete once all scopes were popped.
+     */
+    const std::set<int>& referenceSlots() const { return referenceSlots_; }
 private:
     std::forward_list<Scope> scopes_;
     Scope *objectScope_ = nullptr;
     int nextVariableID_ = 0;
     int maxVariableCount_ = 0;
+    std::set<int> referenceSlots_;
     
     void syncMaxVariableCount();
+    /** Adds the slots of the variables in @c scope that may hold references to the stack map. */
+    void recordReferenceSlots(const Scope &scope);
 };
 
 #endif /* CallableScoper_hpp */
@@ -81,6 +81,7 @@ enum Emojis {
     E_OLDER_WOMAN = 0x1F475,
     E_TACO = 0x1F32E,
     E_INPUT_SYMBOL_LATIN_LETTERS = 0x1F524,
+    E_INPUT_SYMBOL_FOR_LATIN_SMALL_LETTERS = 0x1F521,
     E_CROSS_MARK = 0x274C,
     E_OLDER_MAN = 0x1F474,
     E_THUMBS_UP_SIGN = 0x1F44D,
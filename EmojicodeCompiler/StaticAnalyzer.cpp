@@ -7,6 +7,7 @@
 //
 
 #include <cstring>
+#include <algorithm>
 #include "StaticAnalyzer.hpp"
 #include "StaticFunctionAnalyzer.hpp"
 #include "Writer.hpp"
@@ -18,6 +19,56 @@
 #include "StringPool.hpp"
 #include "ValueType.hpp"
 
+static uint32_t instanceVariableSize(uint8_t kind) {
+    switch (kind) {
+        case IV_SOMETHING:
+            return 16;
+        case IV_BOOLEAN:
+            return 1;
+        default:
+            return 8;
+    }
+}
+
+/**
+ * Lays out the instance variables of @c eclass after those of its superclasses. The variables are grouped by their
+ * storage kind, so that all slots the garbage collector must visit come first.
+ * @param offsets If not @c nullptr, the offset of each of the class’s own instance variables is stored in it.
+ * @returns The size of the instance variable area, which is always a multiple of 8.
+ */
+static uint32_t layoutInstanceVariables(Class *eclass, std::vector<uint32_t> *offsets) {
+    uint32_t size = eclass->superclass ? layoutInstanceVariables(eclass->superclass, nullptr) : 0;
+    auto &variables = eclass->instanceVariables();
+    if (offsets) {
+        offsets->resize(variables.size());
+    }
+    for (uint8_t kind : {IV_SOMETHING, IV_OBJECT, IV_INTEGER, IV_DOUBLE, IV_BOOLEAN}) {
+        for (size_t i = 0; i < variables.size(); i++) {
+            if (variables[i].type.storageKind() == kind) {
+                if (offsets) {
+                    (*offsets)[i] = size;
+                }
+                size += instanceVariableSize(kind);
+            }
+        }
+    }
+    return (size + 7) & ~7;
+}
+
+/** Writes the offsets of the class’s own instance variables of the given kind. */
+static void writeInstanceVariableOffsets(Class *eclass, const std::vector<uint32_t> &offsets, uint8_t kind,
+                                         Writer &writer) {
+    auto &variables = eclass->instanceVariables();
+    writer.writeUInt16(std::count_if(variables.begin(), variables.end(), [kind](const Variable &variable) {
+        return variable.type.storageKind() == kind;
+    }));
+    for (size_t i = 0; i < variables.size(); i++) {
+        if (variables[i].type.storageKind() == kind) {
+            writer.writeEmojicodeChar(offsets[i]);
+        }
+    }
+}
+
 void analyzeClass(Type classType, Writer &writer) {
     auto eclass = classType.eclass();
     
@@ -32,16 +83,20 @@ void analyzeClass(Type classType, Writer &writer) {
     
     Scope objectScope;
     
-    // Get the ID offset for this class by summing up all superclasses instance variable counts
-    int offset = 0;
-    for (Class *aClass = eclass->superclass; aClass != nullptr; aClass = aClass->superclass) {
-        offset += aClass->instanceVariables().size();
+    // Count all instance variables inclusive those of the superclasses
+    size_t instanceVariableCount = 0;
+    for (Class *aClass = eclass; aClass != nullptr; aClass = aClass->superclass) {
+        instanceVariableCount += aClass->instanceVariables().size();
     }
-    auto instanceVariableCount = eclass->instanceVariables().size() + offset;
     if (instanceVariableCount > 65536) {
         throw CompilerErrorException(eclass->position(), "You exceeded the limit of 65,536 instance variables.");
     }
-    writer.writeUInt16(instanceVariableCount);
+    
+    // The engine appends the slots the GC must visit to those of the superclass
+    std::vector<uint32_t> offsets;
+    writer.writeEmojicodeChar(layoutInstanceVariables(eclass, &offsets));
+    writeInstanceVariableOffsets(eclass, offsets, IV_SOMETHING, writer);
+    writeInstanceVariableOffsets(eclass, offsets, IV_OBJECT, writer);
     
     // Number of methods inclusive superclass
     writer.writeUInt16(eclass->nextMethodVti);
@@ -52,8 +107,9 @@ void analyzeClass(Type classType, Writer &writer) {
     writer.writeUInt16(eclass->methodList().size() + eclass->classMethodList().size());
     writer.writeUInt16(eclass->initializerList().size());
     
-    for (Variable var : eclass->instanceVariables()) {
-        var.setId(offset++);
+    for (size_t i = 0; i < eclass->instanceVariables().size(); i++) {
+        Variable var = eclass->instanceVariables()[i];
+        var.setId(offsets[i]);
         objectScope.setLocalVariable(var.definitionToken.value, var);
     }
     
@@ -126,15 +126,17 @@ Type StaticFunctionAnalyzer::parseFunctionCall(Type type, Function *p, const Tok
     return p->returnType.resolveOn(typeContext);
 }
 
-void StaticFunctionAnalyzer::writeCoinForScopesUp(bool inObjectScope, EmojicodeCoin stack,
-                                                  EmojicodeCoin object, SourcePosition p) {
-    if (!inObjectScope) {
+void StaticFunctionAnalyzer::writeVariableAccess(std::pair<Variable&, bool> var, EmojicodeCoin stack,
+                                                 EmojicodeCoin object, SourcePosition p) {
+    if (!var.second) {
         writer.writeCoin(stack, p);
     }
     else {
         writer.writeCoin(object, p);
+        writer.writeCoin(var.first.type.storageKind(), p);
         usedSelf = true;
     }
+    writer.writeCoin(var.first.id(), p);
 }
 
 void StaticFunctionAnalyzer::flowControlBlock(bool block) {
@@ -274,8 +276,7 @@ Type StaticFunctionAnalyzer::parse(const Token &token, Type expectation) {
             
             var.first.uninitalizedError(token);
             
-            writeCoinForScopesUp(var.second, 0x1A, 0x1C, token);
-            writer.writeCoin(var.first.id(), token);
+            writeVariableAccess(var, 0x1A, 0x1C, token);
             
             return var.first.type;
         }
@@ -332,8 +333,7 @@ Type StaticFunctionAnalyzer::parseIdentifier(const Token &token, Type expectatio
                 
                 var.first.mutate(varName);
                 
-                writeCoinForScopesUp(var.second, 0x1B, 0x1D, token);
-                writer.writeCoin(var.first.id(), token);
+                writeVariableAccess(var, 0x1B, 0x1D, token);
                 
                 type = var.first.type;
             }
@@ -384,14 +384,12 @@ Type StaticFunctionAnalyzer::parseIdentifier(const Token &token, Type expectatio
             }
             
             if (token.value[0] == E_COOKING) {
-                writeCoinForScopesUp(var.second, 0x19, 0x1F, token);
+                writeVariableAccess(var, 0x19, 0x1F, token);
             }
             else {
-                writeCoinForScopesUp(var.second, 0x18, 0x1E, token);
+                writeVariableAccess(var, 0x18, 0x1E, token);
             }
             
-            writer.writeCoin(var.first.id(), token);
-            
             return typeNothingness;
         }
         case E_COOKIE: {
@@ -401,7 +399,9 @@ Type StaticFunctionAnalyzer::parseIdentifier(const Token &token, Type expectatio
             int stringCount = 0;
             
             while (stream_.nextTokenIsEverythingBut(E_COOKIE)) {
-                parse(stream_.consumeToken(), token, Type(CL_STRING));
+                auto &operand = stream_.consumeToken();
+                interpolationOperand = &operand;
+                parse(operand, token, Type(CL_STRING));
                 stringCount++;
             }
             stream_.consumeToken(TokenType::Identifier);
@@ -537,6 +537,31 @@ Type StaticFunctionAnalyzer::parseIdentifier(const Token &token, Type expectatio
             int vID = scoper.reserveVariableSlot();
             writer.writeCoin(vID, token);
             
+            if (stream_.nextTokenIs(E_BLACK_RIGHT_POINTING_DOUBLE_TRIANGLE) ||
+                stream_.nextTokenIs(E_BLACK_RIGHT_POINTING_DOUBLE_TRIANGLE_WITH_VERTICAL_BAR)) {
+                // The range literal cannot escape the loop, so no range object is created at all and the loop
+                // receives its start, stop and step directly
+                placeholder.write(0x67);
+                auto &rangeToken = stream_.consumeToken();
+                parse(stream_.consumeToken(), rangeToken, typeInteger);
+                parse(stream_.consumeToken(), rangeToken, typeInteger);
+                if (rangeToken.value[0] == E_BLACK_RIGHT_POINTING_DOUBLE_TRIANGLE_WITH_VERTICAL_BAR) {
+                    parse(stream_.consumeToken(), rangeToken, typeInteger);
+                }
+                else {
+                    // A step of 0 makes the Real-Time Engine choose the default step
+                    writer.writeCoin(0x13, rangeToken);
+                    writer.writeCoin(0, rangeToken);
+                }
+                scoper.currentScope().setLocalVariable(variableToken.value, Variable(typeInteger, vID, true, true, variableToken));
+                
+                flowControlBlock(false);
+                returned = false;
+                scoper.popScopeAndRecommendFrozenVariables();
+                
+                return typeNothingness;
+            }
+            
             Type iteratee = parse(stream_.consumeToken(), token, typeSomeobject);
             
             Type itemType = typeNothingness;
@@ -544,7 +569,7 @@ Type StaticFunctionAnalyzer::parseIdentifier(const Token &token, Type expectatio
             if (iteratee.type() == TypeContent::Class && iteratee.eclass() == CL_LIST) {
                 // If the iteratee is a list, the Real-Time Engine has some special sugar
                 placeholder.write(0x65);
-                writer.writeCoin(scoper.reserveVariableSlot(), token);  //Internally needed
+                writer.writeCoin(scoper.reserveReferenceSlot(), token);  //Internally needed
                 scoper.currentScope().setLocalVariable(variableToken.value, Variable(iteratee.genericArguments[0], vID, true, true, variableToken));
             }
             else if (iteratee.type() == TypeContent::Class && iteratee.eclass() == CL_RANGE) {
@@ -554,7 +579,7 @@ Type StaticFunctionAnalyzer::parseIdentifier(const Token &token, Type expectatio
             }
             else if (typeIsEnumerable(iteratee, &itemType)) {
                 placeholder.write(0x64);
-                writer.writeCoin(scoper.reserveVariableSlot(), token);  //Internally needed
+                writer.writeCoin(scoper.reserveReferenceSlot(), token);  //Internally needed
                 scoper.currentScope().setLocalVariable(variableToken.value, Variable(itemType, vID, true, true, variableToken));
             }
             else {
@@ -843,11 +868,13 @@ Type StaticFunctionAnalyzer::parseIdentifier(const Token &token, Type expectatio
             writer.writeCoin(static_cast<EmojicodeCoin>(function.arguments.size())
                              | (analyzer.usedSelfInBody() ? 1 << 16 : 0), token);
             writer.writeCoin(flattenedResult.second, token);
+            writeStackMap(closureScoper, writer, token);
             
             return function.type();
         }
         case E_LOLLIPOP: {
-            writer.writeCoin(0x70, token);
+            // A method call captured only to be called right away cannot escape, so it is never created
+            writer.writeCoin(stream_.nextTokenIs(E_HOT_PEPPER) ? 0x75 : 0x70, token);
             
             Type type = parse(stream_.consumeToken());
             
@@ -989,6 +1016,15 @@ Type StaticFunctionAnalyzer::parseIdentifier(const Token &token, Type expectatio
                 throw CompilerErrorException(tobject, "You cannot call methods on optionals.");
             }
             
+            if (&token == interpolationOperand && token.value[0] == E_INPUT_SYMBOL_FOR_LATIN_SMALL_LETTERS
+                && type.type() == TypeContent::ValueType && type.valueType() == VT_INTEGER
+                && !stream_.nextTokenIs(E_SPIRAL_SHELL) && !stream_.nextTokenIs(TokenType::ArgumentBracketOpen)) {
+                // The string would only be copied into the 🍪’s result, the integer is therefore written there directly
+                placeholder.write(0x55);
+                parse(stream_.consumeToken(), token, typeInteger);
+                return Type(CL_STRING);
+            }
+            
             Method *method;
             if (type.type() == TypeContent::ValueType) {
                 if (type.valueType() == VT_BOOLEAN) {
@@ -1295,4 +1331,12 @@ void StaticFunctionAnalyzer::writeAndAnalyzeFunction(Function *function, Writer
     
     variableCountPlaceholder.write(scoper.maxVariableCount());
     coinsCountPlaceholder.write();
+    writeStackMap(scoper, writer, function->position());
+}
+
+void StaticFunctionAnalyzer::writeStackMap(const CallableScoper &scoper, Writer &writer, SourcePosition p) {
+    writer.writeCoin(static_cast<EmojicodeCoin>(scoper.referenceSlots().size()), p);
+    for (int slot : scoper.referenceSlots()) {
+        writer.writeCoin(slot, p);
+    }
 }
\ No newline at end of file
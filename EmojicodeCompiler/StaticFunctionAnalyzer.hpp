@@ -76,6 +76,11 @@ private:
     bool calledSuper = false;
     /** The this context in which this function operates. */
     TypeContext typeContext;
+    /** The operand of the 🍪 being compiled, if any. */
+    const Token *interpolationOperand = nullptr;
+    
+    /** Writes the number of slots that may hold references followed by their IDs. */
+    static void writeStackMap(const CallableScoper &scoper, Writer &writer, SourcePosition p);
     
     /**
      * Safely tries to parse the given token, evaluate the associated command and returns the type of that command.
@@ -109,11 +114,13 @@ private:
     Type parseFunctionCall(Type type, Function *p, const Token &token);
     
     /**
-     * Writes a command to access a variable.
+     * Writes a command to access a variable followed by the variable’s ID or, for instance variables, its storage
+     * kind and offset.
      * @param stack The command to access the variable if it is on the stack.
      * @param object The command to access the variable it it is an instance variable.
      */
-    void writeCoinForScopesUp(bool inObjectScope, EmojicodeCoin stack, EmojicodeCoin object, SourcePosition p);
+    void writeVariableAccess(std::pair<Variable&, bool> var, EmojicodeCoin stack, EmojicodeCoin object,
+                             SourcePosition p);
     
     void noReturnError(SourcePosition p);
     void noEffectWarning(const Token &warningToken);
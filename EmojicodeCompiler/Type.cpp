@@ -86,6 +86,41 @@ bool Type::allowsMetaType() {
     return type() == TypeContent::Class || type() == TypeContent::Enum || type() == TypeContent::ValueType;
 }
 
+uint8_t Type::storageKind() const {
+    if (optional() || meta_) {
+        return IV_SOMETHING;
+    }
+    if (type() == TypeContent::Class) {
+        return IV_OBJECT;
+    }
+    if (type() == TypeContent::ValueType) {
+        if (valueType() == VT_INTEGER) {
+            return IV_INTEGER;
+        }
+        if (valueType() == VT_DOUBLE) {
+            return IV_DOUBLE;
+        }
+        if (valueType() == VT_BOOLEAN) {
+            return IV_BOOLEAN;
+        }
+    }
+    return IV_SOMETHING;
+}
+
+bool Type::mayHoldReference() const {
+    if (meta_) {
+        return false;
+    }
+    switch (type()) {
+        case TypeContent::ValueType:
+        case TypeContent::Enum:
+        case TypeContent::Nothingness:
+            return false;
+        default:
+            return true;
+    }
+}
+
 Type Type::resolveReferenceToBaseReferenceOnSuperArguments(TypeContext typeContext) const {
     TypeDefinitionFunctional *c = typeContext.calleeType().typeDefinitionFunctional();
     Type t = *this;
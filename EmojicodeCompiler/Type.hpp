@@ -128,6 +128,11 @@ public:
     bool meta() { return meta_; }
     
     bool allowsMetaType();
+    
+    /** Returns how an instance variable of this type is stored in an object. One of the @c IV_ constants. */
+    uint8_t storageKind() const;
+    /** Returns whether a variable of this type can ever contain an object reference. */
+    bool mayHoldReference() const;
 private:
     union {
         TypeDefinition *typeDefinition_;
@@ -0,0 +1,223 @@
+//
+//  main.cpp
+//  EmojicodeHeapAnalyzer
+//
+//  Reads a heap snapshot written by the Real-Time Engine and prints the shallow and retained sizes per class.
+//
+
+#include <cstdio>
+#include <cstring>
+#include <cinttypes>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <algorithm>
+
+struct Node {
+    std::string className;
+    size_t size;
+    std::vector<size_t> successors;
+    std::vector<size_t> predecessors;
+};
+
+struct ClassStatistics {
+    std::string className;
+    size_t count = 0;
+    size_t shallowSize = 0;
+    size_t retainedSize = 0;
+};
+
+static const size_t kUndefined = SIZE_MAX;
+
+/** Node 0 is the virtual root which references all GC roots. */
+static std::vector<Node> nodes(1);
+
+static bool readSnapshot(FILE *f) {
+    std::unordered_map<uintptr_t, size_t> indices;
+    std::vector<std::pair<uintptr_t, uintptr_t>> edges;
+    indices[0] = 0;
+
+    char line[256];
+    if (!fgets(line, sizeof(line), f) || strncmp(line, "emojicode-heap-snapshot 1", 25) != 0) {
+        fprintf(stderr, "Not an Emojicode heap snapshot.\n");
+        return false;
+    }
+
+    while (fgets(line, sizeof(line), f)) {
+        uintptr_t a, b;
+        size_t size;
+        char name[16];
+        if (sscanf(line, "N %" SCNxPTR " %zu %15s", &a, &size, name) == 3) {
+            indices[a] = nodes.size();
+            Node node;
+            node.className = name;
+            node.size = size;
+            nodes.push_back(node);
+        }
+        else if (sscanf(line, "E %" SCNxPTR " %" SCNxPTR, &a, &b) == 2) {
+            edges.push_back(std::make_pair(a, b));
+        }
+        else {
+            fprintf(stderr, "Malformed line: %s", line);
+            return false;
+        }
+    }
+
+    for (auto edge : edges) {
+        auto from = indices.find(edge.first), to = indices.find(edge.second);
+        if (from == indices.end() || to == indices.end()) {
+            fprintf(stderr, "Reference to unknown object.\n");
+            return false;
+        }
+        nodes[from->second].successors.push_back(to->second);
+        nodes[to->second].predecessors.push_back(from->second);
+    }
+    return true;
+}
+
+/** Returns the nodes reachable from the root in reverse postorder. */
+static std::vector<size_t> reversePostorder() {
+    std::vector<size_t> order;
+    std::vector<bool> visited(nodes.size(), false);
+    std::vector<std::pair<size_t, size_t>> stack;
+    stack.push_back(std::make_pair(0, 0));
+    visited[0] = true;
+
+    while (!stack.empty()) {
+        auto &top = stack.back();
+        if (top.second < nodes[top.first].successors.size()) {
+            size_t next = nodes[top.first].successors[top.second++];
+            if (!visited[next]) {
+                visited[next] = true;
+                stack.push_back(std::make_pair(next, 0));
+            }
+        }
+        else {
+            order.push_back(top.first);
+            stack.pop_back();
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+/**
+ * Computes the immediate dominators using the algorithm by Cooper, Harvey and Kennedy
+ * (“A Simple, Fast Dominance Algorithm”).
+ */
+static std::vector<size_t> immediateDominators(const std::vector<size_t> &order) {
+    std::vector<size_t> orderIndex(nodes.size(), kUndefined);
+    for (size_t i = 0; i < order.size(); i++) {
+        orderIndex[order[i]] = i;
+    }
+
+    std::vector<size_t> idom(nodes.size(), kUndefined);
+    idom[0] = 0;
+
+    auto intersect = [&](size_t a, size_t b) {
+        while (a != b) {
+            while (orderIndex[a] > orderIndex[b]) a = idom[a];
+            while (orderIndex[b] > orderIndex[a]) b = idom[b];
+        }
+        return a;
+    };
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 1; i < order.size(); i++) {
+            size_t n = order[i];
+            size_t newIdom = kUndefined;
+            for (size_t p : nodes[n].predecessors) {
+                if (idom[p] == kUndefined) continue;
+                newIdom = newIdom == kUndefined ? p : intersect(p, newIdom);
+            }
+            if (idom[n] != newIdom) {
+                idom[n] = newIdom;
+                changed = true;
+            }
+        }
+    }
+    return idom;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s snapshot\n", argv[0]);
+        return 1;
+    }
+
+    FILE *f = fopen(argv[1], "r");
+    if (!f) {
+        fprintf(stderr, "Could not open %s.\n", argv[1]);
+        return 1;
+    }
+    bool success = readSnapshot(f);
+    fclose(f);
+    if (!success) {
+        return 1;
+    }
+
+    auto order = reversePostorder();
+    auto idom = immediateDominators(order);
+
+    std::vector<size_t> retained(nodes.size(), 0);
+    for (auto it = order.rbegin(); it != order.rend(); it++) {
+        retained[*it] += nodes[*it].size;
+        if (*it != 0) {
+            retained[idom[*it]] += retained[*it];
+        }
+    }
+
+    std::vector<std::vector<size_t>> dominated(nodes.size());
+    for (size_t i = 1; i < order.size(); i++) {
+        dominated[idom[order[i]]].push_back(order[i]);
+    }
+
+    // An object’s retained size only counts towards its class if it is not dominated by an object of the same
+    // class, otherwise it would be counted twice.
+    std::map<std::string, ClassStatistics> classes;
+    std::map<std::string, size_t> classesOnPath;
+    std::vector<std::pair<size_t, size_t>> stack;
+    stack.push_back(std::make_pair(0, 0));
+    while (!stack.empty()) {
+        auto &top = stack.back();
+        size_t n = top.first;
+        if (top.second == 0 && n != 0) {
+            auto &statistics = classes[nodes[n].className];
+            statistics.className = nodes[n].className;
+            statistics.count++;
+            statistics.shallowSize += nodes[n].size;
+            if (classesOnPath[nodes[n].className]++ == 0) {
+                statistics.retainedSize += retained[n];
+            }
+        }
+        if (top.second < dominated[n].size()) {
+            stack.push_back(std::make_pair(dominated[n][top.second++], 0));
+        }
+        else {
+            if (n != 0) {
+                classesOnPath[nodes[n].className]--;
+            }
+            stack.pop_back();
+        }
+    }
+
+    std::vector<ClassStatistics> sorted;
+    for (auto &pair : classes) {
+        sorted.push_back(pair.second);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const ClassStatistics &a, const ClassStatistics &b) {
+        return a.retainedSize > b.retainedSize;
+    });
+
+    printf("%zu objects, %zu bytes\n\n", order.size() - 1, retained[0]);
+    printf("%-8s %12s %16s %16s\n", "Class", "Count", "Shallow size", "Retained size");
+    for (auto &statistics : sorted) {
+        // Emojis are usually displayed two columns wide
+        printf("%s%*s %12zu %16zu %16zu\n", statistics.className.c_str(), 6, "", statistics.count,
+               statistics.shallowSize, statistics.retainedSize);
+    }
+    return 0;
+}
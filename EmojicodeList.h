@@ -17,12 +17,18 @@ struct List {
     /** The capacity of the list. */
     size_t capacity;
     /**
-     * The array which stores the list items which has a size of @c capacity * sizeof(Something).
-     * Can be @c NULL if @c capacity is 0.
+     * The array which stores the list items. It contains the @c capacity 8-byte payloads of the items followed by
+     * their @c capacity type bytes. Can be @c NULL if @c capacity is 0.
      */
     Object *items;
 };
 
+/**
+ * Allocates an items array for a list with the given capacity.
+ * @warning GC-invoking
+ */
+Object* newListItems(size_t capacity);
+
 /** 
  * Inserts @c o at the end of the list. O(1) 
  * @warning GC-invoking
@@ -0,0 +1,174 @@
+//
+//  AllocationProfiler.c
+//  Emojicode
+//
+//  Samples allocations and attributes them to the bytecode position that caused them.
+//
+
+#include "Emojicode.h"
+#include <string.h>
+#include "utf8.h"
+
+size_t allocationSampleInterval = 0;
+
+typedef struct {
+    EmojicodeCoin *tokenStream;
+    uint32_t tokenCount;
+    EmojicodeChar className;
+    EmojicodeChar name;
+    bool initializer;
+} ProfiledBlock;
+
+static ProfiledBlock *blocks = NULL;
+static size_t blocksCount = 0;
+static size_t blocksCapacity = 0;
+
+typedef struct {
+    /** The token stream position of the allocating thread or @c NULL if unknown. */
+    EmojicodeCoin *position;
+    Class *class;
+    uint64_t samples;
+    /** The estimated number of objects the samples stand for. */
+    double objects;
+} AllocationSite;
+
+static AllocationSite *sites = NULL;
+static size_t sitesCount = 0;
+static size_t sitesCapacity = 0;
+
+static int64_t bytesUntilSample = 0;
+
+void allocationProfilerRegisterBlock(EmojicodeCoin *tokenStream, uint32_t tokenCount, EmojicodeChar className,
+                                     EmojicodeChar name, bool initializer){
+    if (!allocationSampleInterval) {
+        return;
+    }
+    if (blocksCount == blocksCapacity) {
+        blocksCapacity = blocksCapacity ? blocksCapacity * 2 : 256;
+        blocks = realloc(blocks, blocksCapacity * sizeof(ProfiledBlock));
+        if (!blocks) {
+            error("Cannot allocate profiler data!");
+        }
+    }
+    blocks[blocksCount++] = (ProfiledBlock){tokenStream, tokenCount, className, name, initializer};
+}
+
+static size_t siteHash(EmojicodeCoin *position, Class *class){
+    return (((uintptr_t)position >> 2) * 31 + ((uintptr_t)class >> 4)) & (sitesCapacity - 1);
+}
+
+static AllocationSite* findSite(EmojicodeCoin *position, Class *class){
+    if (sitesCount * 2 >= sitesCapacity) {
+        AllocationSite *oldSites = sites;
+        size_t oldCapacity = sitesCapacity;
+        sitesCapacity = sitesCapacity ? sitesCapacity * 2 : 1024;
+        sites = calloc(sitesCapacity, sizeof(AllocationSite));
+        if (!sites) {
+            error("Cannot allocate profiler data!");
+        }
+        for (size_t i = 0; i < oldCapacity; i++) {
+            if (oldSites[i].class) {
+                size_t j = siteHash(oldSites[i].position, oldSites[i].class);
+                while (sites[j].class) j = (j + 1) & (sitesCapacity - 1);
+                sites[j] = oldSites[i];
+            }
+        }
+        free(oldSites);
+    }
+
+    size_t i = siteHash(position, class);
+    while (sites[i].class && (sites[i].position != position || sites[i].class != class)) {
+        i = (i + 1) & (sitesCapacity - 1);
+    }
+    if (!sites[i].class) {
+        sites[i].position = position;
+        sites[i].class = class;
+        sitesCount++;
+    }
+    return &sites[i];
+}
+
+void allocationProfilerRecord(Class *class, size_t size){
+    bytesUntilSample -= size;
+    if (bytesUntilSample > 0) {
+        return;
+    }
+
+    uint64_t samples = 0;
+    while (bytesUntilSample <= 0) {
+        bytesUntilSample += allocationSampleInterval;
+        samples++;
+    }
+
+    AllocationSite *site = findSite(currentThread ? currentThread->tokenStream : NULL, class);
+    site->samples += samples;
+    site->objects += size < allocationSampleInterval ? samples * (double)allocationSampleInterval / size : samples;
+}
+
+static int compareBlocks(const void *a, const void *b){
+    const ProfiledBlock *x = a, *y = b;
+    return x->tokenStream < y->tokenStream ? -1 : x->tokenStream > y->tokenStream;
+}
+
+static int compareSites(const void *a, const void *b){
+    const AllocationSite *x = a, *y = b;
+    return x->samples < y->samples ? 1 : x->samples > y->samples ? -1 : 0;
+}
+
+static ProfiledBlock* blockForPosition(EmojicodeCoin *position){
+    size_t low = 0, high = blocksCount;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (position < blocks[middle].tokenStream) {
+            high = middle;
+        }
+        else if (position > blocks[middle].tokenStream + blocks[middle].tokenCount) {
+            low = middle + 1;
+        }
+        else {
+            return &blocks[middle];
+        }
+    }
+    return NULL;
+}
+
+void printAllocationProfile(){
+#define maxSitesReported 25
+    qsort(blocks, blocksCount, sizeof(ProfiledBlock), compareBlocks);
+
+    size_t count = 0;
+    for (size_t i = 0; i < sitesCapacity; i++) {
+        if (sites[i].class) {
+            sites[count++] = sites[i];
+        }
+    }
+    qsort(sites, count, sizeof(AllocationSite), compareSites);
+
+    fprintf(stderr, "Allocation sites (sampled every %zu bytes):\n", allocationSampleInterval);
+    fprintf(stderr, "%14s %12s  %-6s %s\n", "Bytes", "Objects", "Class", "Site");
+    //Class names are printed as one emoji or "[]", which both are usually two columns wide
+    for (size_t i = 0; i < count && i < maxSitesReported; i++) {
+        char className[5] = {0};
+        if (sites[i].class->name) {
+            u8_wc_toutf8(className, sites[i].class->name);
+        }
+        fprintf(stderr, "%14llu %12.0f  %s    ", (unsigned long long)(sites[i].samples * allocationSampleInterval),
+                sites[i].objects, sites[i].class->name ? className : "[]");
+
+        ProfiledBlock *block = sites[i].position ? blockForPosition(sites[i].position) : NULL;
+        if (block) {
+            char owner[6] = {0}, name[5] = {0};
+            if (block->className) {
+                u8_wc_toutf8(owner, block->className);
+                strcat(owner, " ");
+            }
+            u8_wc_toutf8(name, block->name);
+            fprintf(stderr, " %s%s%s +%td\n", owner, block->initializer ? "🐈 " : "", name,
+                    sites[i].position - block->tokenStream);
+        }
+        else {
+            fprintf(stderr, " (runtime)\n");
+        }
+    }
+#undef maxSitesReported
+}
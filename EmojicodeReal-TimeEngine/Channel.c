@@ -0,0 +1,258 @@
+//
+//  Channel.c
+//  Emojicode
+//
+//  A bounded channel between threads built on a lock-free ring buffer.
+//
+
+#include "Emojicode.h"
+#include "EmojicodeList.h"
+
+typedef struct {
+    /** Tells senders and receivers whether the slot is free for the position they claimed. */
+    _Atomic size_t sequence;
+    Something value;
+} ChannelSlot;
+
+/**
+ * The bounded multi-producer multi-consumer queue described by Dmitry Vyukov. A sender claims a position by
+ * incrementing @c enqueuePosition and publishes its value by advancing the slot’s sequence, a receiver does the same
+ * with @c dequeuePosition. The channel is allocated outside the heap so that threads can sleep on its futex words
+ * while the GC moves the 📡 object.
+ */
+struct Channel {
+    size_t mask;
+    /** Senders and receivers are kept on different cache lines. */
+    _Alignas(64) _Atomic size_t enqueuePosition;
+    _Alignas(64) _Atomic size_t dequeuePosition;
+    /** Incremented whenever a value was sent while receivers were waiting. Waiting receivers sleep on it. */
+    _Alignas(64) _Atomic uint32_t sent;
+    /** Incremented whenever a value was received while senders were waiting. Waiting senders sleep on it. */
+    _Atomic uint32_t received;
+    _Atomic uint32_t waitingReceivers;
+    _Atomic uint32_t waitingSenders;
+    ChannelSlot slots[];
+};
+
+static Channel* channelForThis(Thread *thread){
+    return *(Channel **)objectValue(stackGetThisObject(thread));
+}
+
+/** Wakes the threads sleeping on @c signal if there are any. */
+static void channelNotify(_Atomic uint32_t *signal, _Atomic uint32_t *waiters){
+    //Pairs with the waiting thread, which registers itself before it tries the channel a last time
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(waiters, memory_order_relaxed)) {
+        atomic_fetch_add(signal, 1);
+        futexWake(signal);
+    }
+}
+
+static bool channelTrySend(Channel *channel, Something value){
+    size_t position = atomic_load_explicit(&channel->enqueuePosition, memory_order_relaxed);
+    while (true) {
+        ChannelSlot *slot = &channel->slots[position & channel->mask];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+        if (difference == 0) {
+            if (atomic_compare_exchange_weak_explicit(&channel->enqueuePosition, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                slot->value = value;
+                atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+                break;
+            }
+        }
+        else if (difference < 0) {
+            //The slot still holds a value from the previous round, the channel is full
+            return false;
+        }
+        else {
+            position = atomic_load_explicit(&channel->enqueuePosition, memory_order_relaxed);
+        }
+    }
+    channelNotify(&channel->sent, &channel->waitingReceivers);
+    return true;
+}
+
+static bool channelTryReceive(Channel *channel, Something *value){
+    size_t position = atomic_load_explicit(&channel->dequeuePosition, memory_order_relaxed);
+    while (true) {
+        ChannelSlot *slot = &channel->slots[position & channel->mask];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t difference = (intptr_t)sequence - (intptr_t)(position + 1);
+        if (difference == 0) {
+            if (atomic_compare_exchange_weak_explicit(&channel->dequeuePosition, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                *value = slot->value;
+                writeBarrierSomething(slot->value);
+                slot->value = NOTHINGNESS;
+                atomic_store_explicit(&slot->sequence, position + channel->mask + 1, memory_order_release);
+                break;
+            }
+        }
+        else if (difference < 0) {
+            return false;
+        }
+        else {
+            position = atomic_load_explicit(&channel->dequeuePosition, memory_order_relaxed);
+        }
+    }
+    channelNotify(&channel->received, &channel->waitingSenders);
+    return true;
+}
+
+/** Receives a value and blocks while the channel is empty. The thread does not hold up GC cycles while it waits. */
+static Something channelReceiveWaiting(Channel *channel){
+    Something value;
+    if (channelTryReceive(channel, &value)) {
+        return value;
+    }
+    atomic_fetch_add(&channel->waitingReceivers, 1);
+    while (true) {
+        uint32_t sent = atomic_load(&channel->sent);
+        if (channelTryReceive(channel, &value)) {
+            break;
+        }
+        allowGC();
+        futexWait(&channel->sent, sent);
+        disallowGCAndPauseIfNeeded();
+    }
+    atomic_fetch_sub(&channel->waitingReceivers, 1);
+    return value;
+}
+
+void channelMark(Object *self){
+    Channel *channel = *(Channel **)objectValue(self);
+    if (!channel) {
+        return;
+    }
+    //All threads are stopped, so no value is half sent or half received
+    size_t end = atomic_load_explicit(&channel->enqueuePosition, memory_order_relaxed);
+    for (size_t i = atomic_load_explicit(&channel->dequeuePosition, memory_order_relaxed); i != end; i++) {
+        ChannelSlot *slot = &channel->slots[i & channel->mask];
+        if (isRealObject(slot->value)) {
+            mark(&slot->value.object);
+        }
+    }
+}
+
+void channelDeinitialize(void *value){
+    free(*(Channel **)value);
+}
+
+//MARK: Bridges
+
+static void initChannel(Thread *thread){
+    EmojicodeInteger requested = unwrapInteger(stackGetVariable(0, thread));
+    //The sequence numbers require at least two slots
+    size_t capacity = 2;
+    while (capacity < (size_t)requested && capacity < ((size_t)1 << 40)) {
+        capacity <<= 1;
+    }
+    Channel *channel;
+    if (posix_memalign((void **)&channel, 64, sizeof(Channel) + capacity * sizeof(ChannelSlot)) != 0) {
+        error("Could not allocate channel!");
+    }
+    channel->mask = capacity - 1;
+    atomic_init(&channel->enqueuePosition, 0);
+    atomic_init(&channel->dequeuePosition, 0);
+    atomic_init(&channel->sent, 0);
+    atomic_init(&channel->received, 0);
+    atomic_init(&channel->waitingReceivers, 0);
+    atomic_init(&channel->waitingSenders, 0);
+    for (size_t i = 0; i < capacity; i++) {
+        atomic_init(&channel->slots[i].sequence, i);
+        channel->slots[i].value = NOTHINGNESS;
+    }
+    *(Channel **)objectValue(stackGetThisObject(thread)) = channel;
+}
+
+static Something channelSend(Thread *thread){
+    Channel *channel = channelForThis(thread);
+    if (channelTrySend(channel, stackGetVariable(0, thread))) {
+        return NOTHINGNESS;
+    }
+    atomic_fetch_add(&channel->waitingSenders, 1);
+    while (true) {
+        uint32_t received = atomic_load(&channel->received);
+        //The value may have been moved by the GC while this thread was waiting
+        if (channelTrySend(channel, stackGetVariable(0, thread))) {
+            break;
+        }
+        allowGC();
+        futexWait(&channel->received, received);
+        disallowGCAndPauseIfNeeded();
+    }
+    atomic_fetch_sub(&channel->waitingSenders, 1);
+    return NOTHINGNESS;
+}
+
+static Something channelTrySendBridge(Thread *thread){
+    return channelTrySend(channelForThis(thread), stackGetVariable(0, thread)) ? EMOJICODE_TRUE : EMOJICODE_FALSE;
+}
+
+static Something channelReceive(Thread *thread){
+    return channelReceiveWaiting(channelForThis(thread));
+}
+
+static Something channelTryReceiveBridge(Thread *thread){
+    Something value;
+    return channelTryReceive(channelForThis(thread), &value) ? value : NOTHINGNESS;
+}
+
+static Something channelReceiveBatch(Thread *thread){
+    Channel *channel = channelForThis(thread);
+    EmojicodeInteger max = unwrapInteger(stackGetVariable(0, thread));
+    
+    stackPush(stackGetThisContext(thread), 1, 0, thread);
+    stackSetVariable(0, somethingObject(newObject(CL_LIST)), thread);
+    if (max > 0) {
+        //Receiving may let the GC move the list, which is therefore only read afterwards. The received value is
+        //appended before anything else is allocated, which could move it.
+        Something value = channelReceiveWaiting(channel);
+        listAppend(stackGetVariable(0, thread).object, value, thread);
+        for (EmojicodeInteger i = 1; i < max && channelTryReceive(channel, &value); i++) {
+            listAppend(stackGetVariable(0, thread).object, value, thread);
+        }
+    }
+    Something list = stackGetVariable(0, thread);
+    stackPop(thread);
+    return list;
+}
+
+static Something channelCount(Thread *thread){
+    Channel *channel = channelForThis(thread);
+    size_t dequeuePosition = atomic_load(&channel->dequeuePosition);
+    size_t enqueuePosition = atomic_load(&channel->enqueuePosition);
+    //A receiver may have claimed a position before the sender’s value was published
+    return somethingInteger(enqueuePosition > dequeuePosition ? (EmojicodeInteger)(enqueuePosition - dequeuePosition)
+                                                              : 0);
+}
+
+static Something channelCapacity(Thread *thread){
+    return somethingInteger((EmojicodeInteger)channelForThis(thread)->mask + 1);
+}
+
+FunctionFunctionPointer channelMethodForName(EmojicodeChar name){
+    switch (name) {
+        case 0x1f4e4: //📤
+            return channelSend;
+        case 0x1f4ee: //📮
+            return channelTrySendBridge;
+        case 0x1f4e5: //📥
+            return channelReceive;
+        case 0x1f4ed: //📭
+            return channelTryReceiveBridge;
+        case 0x1f4e6: //📦
+            return channelReceiveBatch;
+        case 0x1f414: //🐔
+            return channelCount;
+        case 0x1f4cf: //📏
+            return channelCapacity;
+    }
+    return NULL;
+}
+
+InitializerFunctionFunctionPointer channelInitializerForName(EmojicodeChar name){
+    return initChannel;
+}
@@ -0,0 +1,460 @@
+//
+//  Coroutine.c
+//  Emojicode
+//
+//  Lightweight coroutines multiplexed on a few carrier threads.
+//
+
+#define _XOPEN_SOURCE 700
+#define _DEFAULT_SOURCE
+#include "Emojicode.h"
+#include <ucontext.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+/** The VM stack and the native stack of a coroutine may both grow up to this many bytes. */
+#define coroutineStackSize (512 * 1024)
+
+typedef void (*SuspendAction)(Coroutine *coroutine, void *argument);
+
+/**
+ * A coroutine runs on its own VM stack and its own native stack, but has no OS thread. A carrier thread switches to
+ * it until it finishes or suspends itself, and then runs the next coroutine from the run queue.
+ *
+ * The coroutine’s @c Thread is part of the thread list, so the GC scans its VM stack even while it is suspended. It is
+ * only running while a carrier executes it and is safe otherwise.
+ */
+struct Coroutine {
+    Thread *thread;
+    ucontext_t context;
+    /** The context of the carrier that runs the coroutine, to which it switches when it suspends. */
+    ucontext_t *carrierContext;
+    Byte *nativeStack;
+    size_t nativeStackMappingSize;
+    /** Called by the carrier once the coroutine suspended itself. Without an action the coroutine is run again later. */
+    SuspendAction suspendAction;
+    void *suspendArgument;
+    /** The next coroutine in the run queue or in the list of coroutines waiting for the same coroutine to finish. */
+    Coroutine *next;
+
+    /** Protects @c finished and @c joiners. */
+    pthread_mutex_t mutex;
+    /** Signaled when the coroutine finished. OS threads that join the coroutine wait on it. */
+    pthread_cond_t finishedCondition;
+    bool finished;
+    /** Coroutines that wait for this coroutine to finish. */
+    Coroutine *joiners;
+
+    int waitingFileDescriptor;
+    /** One reference is owned by the 🌀 object and one by the coroutine until it finished. */
+    _Atomic size_t references;
+};
+
+/** The coroutine the carrier on this OS thread currently runs or @c NULL. */
+static _Thread_local Coroutine *currentCoroutine = NULL;
+
+static pthread_once_t schedulerOnce = PTHREAD_ONCE_INIT;
+static pthread_mutex_t runQueueMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t runQueueCondition = PTHREAD_COND_INITIALIZER;
+static Coroutine *runQueueHead = NULL;
+static Coroutine *runQueueTail = NULL;
+
+static void coroutineRelease(Coroutine *coroutine){
+    if (atomic_fetch_sub(&coroutine->references, 1) == 1) {
+        pthread_mutex_destroy(&coroutine->mutex);
+        pthread_cond_destroy(&coroutine->finishedCondition);
+        free(coroutine);
+    }
+}
+
+/** Appends @c coroutine to the run queue. */
+static void coroutineSchedule(Coroutine *coroutine){
+    coroutine->next = NULL;
+    pthread_mutex_lock(&runQueueMutex);
+    if (runQueueTail) {
+        runQueueTail->next = coroutine;
+    }
+    else {
+        runQueueHead = coroutine;
+    }
+    runQueueTail = coroutine;
+    pthread_cond_signal(&runQueueCondition);
+    pthread_mutex_unlock(&runQueueMutex);
+}
+
+/**
+ * Switches from the running coroutine back to its carrier, which calls @c action once the coroutine’s context has been
+ * saved. The action must make sure the coroutine is scheduled again eventually.
+ *
+ * The coroutine may be resumed by another carrier. The carrier has made the thread running again when this function
+ * returns, and objects may have been moved meanwhile.
+ */
+static void coroutineSuspend(Coroutine *coroutine, SuspendAction action, void *argument){
+    coroutine->suspendAction = action;
+    coroutine->suspendArgument = argument;
+    allowGC();
+    swapcontext(&coroutine->context, coroutine->carrierContext);
+}
+
+//MARK: Poller
+
+#ifdef __linux__
+
+typedef struct {
+    uint64_t deadline;
+    Coroutine *coroutine;
+} Timer;
+
+static int pollerDescriptor;
+/** An eventfd that interrupts the poller when a timer was added that expires before all others. */
+static int pollerWakeDescriptor;
+static pthread_mutex_t timersMutex = PTHREAD_MUTEX_INITIALIZER;
+/** A binary min-heap of the sleeping coroutines ordered by their deadlines. */
+static Timer *timers = NULL;
+static size_t timersCount = 0;
+static size_t timersCapacity = 0;
+
+static uint64_t monotonicMicroseconds(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void timersPush(Timer timer){
+    if (timersCount == timersCapacity) {
+        timersCapacity = timersCapacity ? timersCapacity * 2 : 64;
+        timers = realloc(timers, timersCapacity * sizeof(Timer));
+        if (!timers) {
+            error("Could not allocate timers!");
+        }
+    }
+    size_t i = timersCount++;
+    while (i > 0 && timers[(i - 1) / 2].deadline > timer.deadline) {
+        timers[i] = timers[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    timers[i] = timer;
+}
+
+static Timer timersPop(){
+    Timer top = timers[0];
+    Timer last = timers[--timersCount];
+    size_t i = 0;
+    while (2 * i + 1 < timersCount) {
+        size_t child = 2 * i + 1;
+        if (child + 1 < timersCount && timers[child + 1].deadline < timers[child].deadline) {
+            child++;
+        }
+        if (last.deadline <= timers[child].deadline) {
+            break;
+        }
+        timers[i] = timers[child];
+        i = child;
+    }
+    timers[i] = last;
+    return top;
+}
+
+/** Waits for descriptors and timers and schedules the coroutines that waited for them. Never touches the heap. */
+static void* pollerMain(void *unused){
+#define maxEvents 64
+    struct epoll_event events[maxEvents];
+    while (true) {
+        int timeout = -1;
+        pthread_mutex_lock(&timersMutex);
+        if (timersCount) {
+            uint64_t now = monotonicMicroseconds();
+            timeout = timers[0].deadline > now ? (int)((timers[0].deadline - now + 999) / 1000) : 0;
+        }
+        pthread_mutex_unlock(&timersMutex);
+
+        int count = epoll_wait(pollerDescriptor, events, maxEvents, timeout);
+        for (int i = 0; i < count; i++) {
+            Coroutine *coroutine = events[i].data.ptr;
+            if (!coroutine) {
+                uint64_t value;
+                read(pollerWakeDescriptor, &value, sizeof(value));
+                continue;
+            }
+            //The registration is removed before the coroutine can close the descriptor
+            epoll_ctl(pollerDescriptor, EPOLL_CTL_DEL, coroutine->waitingFileDescriptor, NULL);
+            coroutineSchedule(coroutine);
+        }
+
+        pthread_mutex_lock(&timersMutex);
+        uint64_t now = monotonicMicroseconds();
+        while (timersCount && timers[0].deadline <= now) {
+            coroutineSchedule(timersPop().coroutine);
+        }
+        pthread_mutex_unlock(&timersMutex);
+    }
+#undef maxEvents
+    return NULL;
+}
+
+static void startPoller(){
+    pollerDescriptor = epoll_create1(EPOLL_CLOEXEC);
+    pollerWakeDescriptor = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    struct epoll_event event = {.events = EPOLLIN, .data.ptr = NULL};
+    if (pollerDescriptor == -1 || pollerWakeDescriptor == -1 ||
+        epoll_ctl(pollerDescriptor, EPOLL_CTL_ADD, pollerWakeDescriptor, &event) == -1) {
+        error("Could not create the coroutine poller!");
+    }
+    pthread_t poller;
+    pthread_create(&poller, NULL, pollerMain, NULL);
+    pthread_detach(poller);
+}
+
+/** Registers the suspended coroutine for its descriptor. The registration fires once. */
+static void waitForFileDescriptorAction(Coroutine *coroutine, void *events){
+    struct epoll_event event = {.events = (uint32_t)(uintptr_t)events | EPOLLONESHOT, .data.ptr = coroutine};
+    if (epoll_ctl(pollerDescriptor, EPOLL_CTL_ADD, coroutine->waitingFileDescriptor, &event) == -1) {
+        //Another coroutine may wait for the same descriptor, this coroutine will simply try again
+        coroutineSchedule(coroutine);
+    }
+}
+
+static void sleepAction(Coroutine *coroutine, void *deadline){
+    pthread_mutex_lock(&timersMutex);
+    timersPush((Timer){*(uint64_t *)deadline, coroutine});
+    bool earliest = timers[0].coroutine == coroutine;
+    pthread_mutex_unlock(&timersMutex);
+    if (earliest) {
+        uint64_t one = 1;
+        write(pollerWakeDescriptor, &one, sizeof(one));
+    }
+}
+
+#endif
+
+bool coroutineWaitForFileDescriptor(int fd, bool writing){
+#ifdef __linux__
+    Coroutine *coroutine = currentCoroutine;
+    struct stat status;
+    //Regular files and directories are always ready and cannot be registered with epoll
+    if (!coroutine || fstat(fd, &status) != 0 || S_ISREG(status.st_mode) || S_ISDIR(status.st_mode)) {
+        return false;
+    }
+    coroutine->waitingFileDescriptor = fd;
+    coroutineSuspend(coroutine, waitForFileDescriptorAction, (void *)(uintptr_t)(writing ? EPOLLOUT : EPOLLIN));
+    return true;
+#else
+    return false;
+#endif
+}
+
+//MARK: Carriers
+
+/** Runs coroutines from the run queue on the calling OS thread forever. */
+static void* carrierMain(void *unused){
+    ucontext_t carrierContext;
+    while (true) {
+        pthread_mutex_lock(&runQueueMutex);
+        while (!runQueueHead) {
+            pthread_cond_wait(&runQueueCondition, &runQueueMutex);
+        }
+        Coroutine *coroutine = runQueueHead;
+        runQueueHead = coroutine->next;
+        if (!runQueueHead) {
+            runQueueTail = NULL;
+        }
+        pthread_mutex_unlock(&runQueueMutex);
+
+        coroutine->carrierContext = &carrierContext;
+        currentCoroutine = coroutine;
+        currentThread = coroutine->thread;
+        disallowGCAndPauseIfNeeded();
+        swapcontext(&carrierContext, &coroutine->context);
+
+        //The coroutine is safe again. Once it has been scheduled it may already run on another carrier.
+        SuspendAction action = coroutine->suspendAction;
+        coroutine->suspendAction = NULL;
+        if (action) {
+            action(coroutine, coroutine->suspendArgument);
+        }
+        else {
+            coroutineSchedule(coroutine);
+        }
+        currentCoroutine = NULL;
+        currentThread = NULL;
+    }
+    return NULL;
+}
+
+static void startScheduler(){
+#ifdef __linux__
+    startPoller();
+#endif
+    long carriers = sysconf(_SC_NPROCESSORS_ONLN);
+    for (long i = 0; i < (carriers > 0 ? carriers : 1); i++) {
+        pthread_t carrier;
+        pthread_create(&carrier, NULL, carrierMain, NULL);
+        pthread_detach(carrier);
+    }
+}
+
+//MARK: Coroutines
+
+/** Called by the carrier after the coroutine returned from its callable. */
+static void finishAction(Coroutine *coroutine, void *unused){
+    //currentThread is still the coroutine’s thread, which removeThread expects
+    removeThread(coroutine->thread);
+    munmap(coroutine->nativeStack, coroutine->nativeStackMappingSize);
+
+    pthread_mutex_lock(&coroutine->mutex);
+    coroutine->finished = true;
+    Coroutine *joiners = coroutine->joiners;
+    coroutine->joiners = NULL;
+    pthread_cond_broadcast(&coroutine->finishedCondition);
+    pthread_mutex_unlock(&coroutine->mutex);
+
+    while (joiners) {
+        Coroutine *next = joiners->next;
+        coroutineSchedule(joiners);
+        joiners = next;
+    }
+    coroutineRelease(coroutine);
+}
+
+/** The pointer to the coroutine is passed in two halves because @c makecontext only passes @c int arguments. */
+static void coroutineMain(unsigned int low, unsigned int high){
+    Coroutine *coroutine = (Coroutine *)(((uintptr_t)high << 16 << 16) | low);
+    Thread *thread = coroutine->thread;
+    stackSetNativeStackSize(coroutineStackSize, thread);
+    Object *callable = stackGetThisObject(thread);
+    stackPop(thread);
+    executeCallableExtern(callable, NULL, thread);
+    coroutineSuspend(coroutine, finishAction, NULL);
+}
+
+static void initCoroutine(Thread *thread){
+    pthread_once(&schedulerOnce, startScheduler);
+
+    Coroutine *coroutine = malloc(sizeof(Coroutine));
+    if (!coroutine) {
+        error("Could not allocate coroutine!");
+    }
+    size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    coroutine->nativeStackMappingSize = coroutineStackSize + pageSize;
+    coroutine->nativeStack = mmap(NULL, coroutine->nativeStackMappingSize, PROT_READ | PROT_WRITE,
+                                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (coroutine->nativeStack == MAP_FAILED) {
+        error("Could not allocate coroutine stack!");
+    }
+    //A guard page turns an overflow of the native stack into a crash instead of a corruption of other memory
+    mprotect(coroutine->nativeStack, pageSize, PROT_NONE);
+
+    pthread_mutex_init(&coroutine->mutex, NULL);
+    pthread_cond_init(&coroutine->finishedCondition, NULL);
+    coroutine->finished = false;
+    coroutine->joiners = NULL;
+    coroutine->suspendAction = NULL;
+    atomic_init(&coroutine->references, 2);
+
+    coroutine->thread = allocateThread(coroutineStackSize);
+    stackPush(stackGetVariable(0, thread), 0, 0, coroutine->thread);
+
+    getcontext(&coroutine->context);
+    coroutine->context.uc_stack.ss_sp = coroutine->nativeStack + pageSize;
+    coroutine->context.uc_stack.ss_size = coroutineStackSize;
+    coroutine->context.uc_link = NULL;
+    uintptr_t address = (uintptr_t)coroutine;
+    makecontext(&coroutine->context, (void (*)(void))coroutineMain, 2, (unsigned int)(address & 0xFFFFFFFF),
+                (unsigned int)(address >> 16 >> 16));
+
+    *(Coroutine **)objectValue(stackGetThisObject(thread)) = coroutine;
+    coroutineSchedule(coroutine);
+}
+
+static void joinAction(Coroutine *joiner, void *target){
+    Coroutine *coroutine = target;
+    pthread_mutex_lock(&coroutine->mutex);
+    if (coroutine->finished) {
+        pthread_mutex_unlock(&coroutine->mutex);
+        coroutineSchedule(joiner);
+        return;
+    }
+    joiner->next = coroutine->joiners;
+    coroutine->joiners = joiner;
+    pthread_mutex_unlock(&coroutine->mutex);
+}
+
+static Something coroutineJoin(Thread *thread){
+    Coroutine *coroutine = *(Coroutine **)objectValue(stackGetThisObject(thread));
+    if (currentCoroutine) {
+        coroutineSuspend(currentCoroutine, joinAction, coroutine);
+        return NOTHINGNESS;
+    }
+    allowGC();
+    pthread_mutex_lock(&coroutine->mutex);
+    while (!coroutine->finished) {
+        pthread_cond_wait(&coroutine->finishedCondition, &coroutine->mutex);
+    }
+    pthread_mutex_unlock(&coroutine->mutex);
+    disallowGCAndPauseIfNeeded();
+    return NOTHINGNESS;
+}
+
+static Something coroutineIsFinished(Thread *thread){
+    Coroutine *coroutine = *(Coroutine **)objectValue(stackGetThisObject(thread));
+    pthread_mutex_lock(&coroutine->mutex);
+    bool finished = coroutine->finished;
+    pthread_mutex_unlock(&coroutine->mutex);
+    return finished ? EMOJICODE_TRUE : EMOJICODE_FALSE;
+}
+
+static Something coroutineYield(Thread *thread){
+    if (currentCoroutine) {
+        coroutineSuspend(currentCoroutine, NULL, NULL);
+    }
+    else {
+        sched_yield();
+    }
+    return NOTHINGNESS;
+}
+
+static Something coroutineSleep(Thread *thread){
+    EmojicodeInteger microseconds = unwrapInteger(stackGetVariable(0, thread));
+#ifdef __linux__
+    if (currentCoroutine) {
+        uint64_t deadline = monotonicMicroseconds() + (microseconds > 0 ? (uint64_t)microseconds : 0);
+        coroutineSuspend(currentCoroutine, sleepAction, &deadline);
+        return NOTHINGNESS;
+    }
+#endif
+    if (microseconds > 0) {
+        allowGC();
+        usleep((useconds_t)microseconds);
+        disallowGCAndPauseIfNeeded();
+    }
+    return NOTHINGNESS;
+}
+
+void coroutineDeinitialize(void *value){
+    coroutineRelease(*(Coroutine **)value);
+}
+
+FunctionFunctionPointer coroutineMethodForName(EmojicodeChar name){
+    switch (name) {
+        case 0x1f6c2: //🛂
+            return coroutineJoin;
+        case 0x2705: //✅
+            return coroutineIsFinished;
+        case 0x23ed: //⏭
+            return coroutineYield;
+        case 0x23f2: //⏲
+            return coroutineSleep;
+    }
+    return NULL;
+}
+
+InitializerFunctionFunctionPointer coroutineInitializerForName(EmojicodeChar name){
+    return initCoroutine;
+}
@@ -10,6 +10,7 @@
 #include <string.h>
 #include <limits.h>
 #include <math.h>
+#include <sys/resource.h>
 
 #include "Emojicode.h"
 
@@ -28,9 +29,7 @@ Class *CL_CAPTURED_FUNCTION_CALL;
 Class *CL_CLOSURE;
 Class *CL_RANGE;
 
-static Class cl_array = {
-    NULL, NULL, NULL, 0, 0, NULL, 0, 0, 0, NULL, NULL, 0, 0
-};
+static Class cl_array;
 Class *CL_ARRAY = &cl_array;
 
 char **cliArguments;
@@ -110,6 +109,20 @@ static Something runFunctionPointerBlock(Thread *thread, uint32_t length){
     return NOTHINGNESS;
 }
 
+/** Runs the following block for each integer in @c range, which is stored into @c variable. */
+static void forEachInRange(EmojicodeCoin variable, EmojicodeRange range, Thread *thread){
+    EmojicodeCoin *begin = thread->tokenStream;
+    for (EmojicodeInteger i = range.start; i != range.stop; i += range.step) {
+        stackSetVariable(variable, somethingInteger(i), thread);
+
+        if(runBlock(thread)){
+            return;
+        }
+        thread->tokenStream = begin;
+    }
+    passBlock(thread);
+}
+
 static Class* readClass(Thread *thread) {
     return parse(consumeCoin(thread), thread).eclass;
 }
@@ -143,18 +156,20 @@ Something unwrapOptional(Something sth) {
 
 Something executeCallableExtern(Object *callable, Something *args, Thread *thread){
     if (callable->class == CL_CAPTURED_FUNCTION_CALL) {
-        CapturedFunctionCall *cmc = callable->value;
+        CapturedFunctionCall *cmc = objectValue(callable);
         Function *method = cmc->function;
         
         Something ret;
         if (method->native) {
-            Something *t = stackReserveFrame(cmc->callee, method->argumentCount, thread);
+            Something *t = stackReserveArgumentFrame(cmc->callee, method->argumentCount, method->argumentCount, NULL,
+                                                     thread);
             memcpy(t, args, method->argumentCount * sizeof(Something));
             stackPushReservedFrame(thread);
             ret = method->handler(thread);
         }
         else {
-            Something *t = stackReserveFrame(cmc->callee, method->variableCount, thread);
+            Something *t = stackReserveArgumentFrame(cmc->callee, method->variableCount, method->argumentCount,
+                                                     method->stackMap, thread);
             memcpy(t, args, method->argumentCount * sizeof(Something));
             stackPushReservedFrame(thread);
             
@@ -170,13 +185,14 @@ Something executeCallableExtern(Object *callable, Something *args, Thread *threa
         return ret;
     }
     else {
-        Closure *c = callable->value;
+        Closure *c = objectValue(callable);
         
-        Something *t = stackReserveFrame(c->thisContext, c->variableCount, thread);
+        Something *t = stackReserveArgumentFrame(c->thisContext, c->variableCount, c->argumentCount, c->stackMap,
+                                                 thread);
         memcpy(t, args, c->argumentCount * sizeof(Something));
         stackPushReservedFrame(thread);
         
-        Something *cv = c->capturedVariables->value;
+        Something *cv = objectValue(c->capturedVariables);
         for (uint8_t i = 0; i < c->capturedVariablesCount; i++) {
             stackSetVariable(c->argumentCount + i, cv[i], thread);
         }
@@ -200,13 +216,16 @@ Something performInitializer(Class *class, InitializerFunction *initializer, Obj
         stackPush(somethingObject(object), initializer->argumentCount, initializer->argumentCount, thread);
         initializer->handler(thread);
         
-        if(object->value == NULL){
+        if (thread->initializerFailed) {
+            thread->initializerFailed = false;
+            discardFailedObject(stackGetThisObject(thread));
             stackPop(thread);
             return NOTHINGNESS;
         }
     }
     else {
-        stackPush(somethingObject(object), initializer->variableCount, initializer->argumentCount, thread);
+        stackPushFunction(somethingObject(object), initializer->variableCount, initializer->argumentCount,
+                          initializer->stackMap, thread);
         EmojicodeCoin *preCoinStream = thread->tokenStream;
         
         thread->tokenStream = initializer->tokenStream;
@@ -237,7 +256,7 @@ Something performFunction(Function *method, Something this, Thread *thread){
         ret = method->handler(thread);
     }
     else {
-        stackPush(this, method->variableCount, method->argumentCount, thread);
+        stackPushFunction(this, method->variableCount, method->argumentCount, method->stackMap, thread);
         
         EmojicodeCoin *preCoinStream = thread->tokenStream;
         
@@ -332,22 +351,27 @@ Something parse(EmojicodeCoin coin, Thread *thread){
             return NOTHINGNESS;
         }
         case 0x1C: {
-            EmojicodeCoin index = consumeCoin(thread);
-            return objectGetVariable(stackGetThisObject(thread), index);
+            EmojicodeCoin kind = consumeCoin(thread);
+            EmojicodeCoin offset = consumeCoin(thread);
+            return objectGetVariable(stackGetThisObject(thread), kind, offset);
         }
         case 0x1D: {
-            EmojicodeCoin index = consumeCoin(thread);
-            objectSetVariable(stackGetThisObject(thread), index, parse(consumeCoin(thread), thread));
+            EmojicodeCoin kind = consumeCoin(thread);
+            EmojicodeCoin offset = consumeCoin(thread);
+            Something value = parse(consumeCoin(thread), thread);
+            objectSetVariable(stackGetThisObject(thread), kind, offset, value);
             return NOTHINGNESS;
         }
         case 0x1E: {
-            EmojicodeCoin index = consumeCoin(thread);
-            objectIncrementVariable(stackGetThisObject(thread), index);
+            EmojicodeCoin kind = consumeCoin(thread);
+            EmojicodeCoin offset = consumeCoin(thread);
+            objectIncrementVariable(stackGetThisObject(thread), kind, offset);
             return NOTHINGNESS;
         }
         case 0x1F: {
-            EmojicodeCoin index = consumeCoin(thread);
-            objectDecrementVariable(stackGetThisObject(thread), index);
+            EmojicodeCoin kind = consumeCoin(thread);
+            EmojicodeCoin offset = consumeCoin(thread);
+            objectDecrementVariable(stackGetThisObject(thread), kind, offset);
             return NOTHINGNESS;
         }
         //Operators
@@ -572,14 +596,25 @@ Something parse(EmojicodeCoin coin, Thread *thread){
         case 0x52: {
             EmojicodeCoin stringCount = consumeCoin(thread);
             Something *t = stackReserveFrame(NOTHINGNESS, stringCount + 1, thread);
+            //Integers preceded by 0x55 are written into the result directly, their base is stored here
+            EmojicodeInteger bases[stringCount];
             
             EmojicodeInteger length = 0;
             
             for (EmojicodeCoin i = 0; i < stringCount; i++) {
-                Something sm = parse(consumeCoin(thread), thread);
-                t[i] = sm;
-                String *string = sm.object->value;
-                length += string->length;
+                EmojicodeCoin coin = consumeCoin(thread);
+                if (coin == 0x55) {
+                    t[i] = parse(consumeCoin(thread), thread);
+                    bases[i] = parse(consumeCoin(thread), thread).raw;
+                    length += integerStringLength(t[i].raw, bases[i]);
+                }
+                else {
+                    Something sm = parse(coin, thread);
+                    t[i] = sm;
+                    bases[i] = 0;
+                    String *string = objectValue(sm.object);
+                    length += string->length;
+                }
             }
             
             stackPushReservedFrame(thread);
@@ -589,16 +624,22 @@ Something parse(EmojicodeCoin coin, Thread *thread){
             stackSetVariable(stringCount, somethingObject(object), thread);
             
             Object *characters = newArray(length * sizeof(EmojicodeChar));
-            EmojicodeChar *chars = characters->value;
+            EmojicodeChar *chars = objectValue(characters);
             EmojicodeChar *writeChars = chars;
             
             Something sm = stackGetVariable(stringCount, thread);
-            String *string = sm.object->value;
+            String *string = objectValue(sm.object);
             
             for (int i = 0; i < stringCount; i++) {
-                Object *o = stackGetVariable(i, thread).object;
-                String *string = o->value;
-                memcpy(writeChars, string->characters->value, string->length * sizeof(EmojicodeChar));
+                Something part = stackGetVariable(i, thread);
+                if (bases[i]) {
+                    EmojicodeInteger d = integerStringLength(part.raw, bases[i]);
+                    integerWriteString(part.raw, bases[i], d, writeChars);
+                    writeChars += d;
+                    continue;
+                }
+                String *string = objectValue(part.object);
+                memcpy(writeChars, objectValue(string->characters), string->length * sizeof(EmojicodeChar));
                 writeChars += string->length;
             }
             
@@ -613,7 +654,7 @@ Something parse(EmojicodeCoin coin, Thread *thread){
             EmojicodeInteger start = parse(consumeCoin(thread), thread).raw;
             EmojicodeInteger stop = parse(consumeCoin(thread), thread).raw;
             Object *object = newObject(CL_RANGE);
-            EmojicodeRange *range = object->value;
+            EmojicodeRange *range = objectValue(object);
             range->start = start;
             range->stop = stop;
             rangeSetDefaultStep(range);
@@ -624,7 +665,7 @@ Something parse(EmojicodeCoin coin, Thread *thread){
             EmojicodeInteger stop = parse(consumeCoin(thread), thread).raw;
             EmojicodeInteger step = parse(consumeCoin(thread), thread).raw;
             Object *object = newObject(CL_RANGE);
-            EmojicodeRange *range = object->value;
+            EmojicodeRange *range = objectValue(object);
             range->start = start;
             range->stop = stop;
             range->step = step;
@@ -739,11 +780,11 @@ Something parse(EmojicodeCoin coin, Thread *thread){
             
             EmojicodeCoin listObjectVariable = consumeCoin(thread);
             stackSetVariable(listObjectVariable, losm, thread);
-            List *list = losm.object->value;
+            List *list = objectValue(losm.object);
             
             EmojicodeCoin *begin = thread->tokenStream;
             
-            for (size_t i = 0; i < (list = stackGetVariable(listObjectVariable, thread).object->value)->count; i++) {
+            for (size_t i = 0; i < (list = objectValue(stackGetVariable(listObjectVariable, thread).object))->count; i++) {
                 stackSetVariable(variable, unwrapOptional(listGet(list, i)), thread);
                 
                 if(runBlock(thread)){
@@ -757,31 +798,31 @@ Something parse(EmojicodeCoin coin, Thread *thread){
         }
         case 0x66: {
             EmojicodeCoin variable = consumeCoin(thread);
-            EmojicodeRange range = *(EmojicodeRange *)parse(consumeCoin(thread), thread).object->value;
-            EmojicodeCoin *begin = thread->tokenStream;
-            for (EmojicodeInteger i = range.start; i != range.stop; i += range.step) {
-                stackSetVariable(variable, somethingInteger(i), thread);
-                
-                if(runBlock(thread)){
-                    return NOTHINGNESS;
-                }
-                thread->tokenStream = begin;
-            }
-            passBlock(thread);
-            
+            EmojicodeRange range = *(EmojicodeRange *)objectValue(parse(consumeCoin(thread), thread).object);
+            forEachInRange(variable, range, thread);
+            return NOTHINGNESS;
+        }
+        case 0x67: { //MARK: foreach for range literals, which are never allocated
+            EmojicodeCoin variable = consumeCoin(thread);
+            EmojicodeRange range;
+            range.start = parse(consumeCoin(thread), thread).raw;
+            range.stop = parse(consumeCoin(thread), thread).raw;
+            range.step = parse(consumeCoin(thread), thread).raw;
+            if (range.step == 0) rangeSetDefaultStep(&range);
+            forEachInRange(variable, range, thread);
             return NOTHINGNESS;
         }
         case 0x70: {
             Object *callable = parse(consumeCoin(thread), thread).object;
             if (callable->class == CL_CAPTURED_FUNCTION_CALL) {
-                CapturedFunctionCall *cmc = callable->value;
+                CapturedFunctionCall *cmc = objectValue(callable);
                 return performFunction(cmc->function, cmc->callee, thread);
             }
             else {
-                Closure *c = callable->value;
-                stackPush(c->thisContext, c->variableCount, c->argumentCount, thread);
+                Closure *c = objectValue(callable);
+                stackPushFunction(c->thisContext, c->variableCount, c->argumentCount, c->stackMap, thread);
                 
-                Something *cv = c->capturedVariables->value;
+                Something *cv = objectValue(c->capturedVariables);
                 for (uint8_t i = 0; i < c->capturedVariablesCount; i++) {
                     stackSetVariable(c->argumentCount + i, cv[i], thread);
                 }
@@ -796,28 +837,32 @@ Something parse(EmojicodeCoin coin, Thread *thread){
             }
         }
         case 0x71: {
-            stackPush(stackGetThisContext(thread), 1, 0, thread);
-            stackSetVariable(0, somethingObject(newObject(CL_CLOSURE)), thread);
-            
-            Object *co = stackGetVariable(0, thread).object;
-            Closure *c = co->value;
-            
-            c->variableCount = consumeCoin(thread);
-            c->coinCount = consumeCoin(thread);
-            c->tokenStream = thread->tokenStream;
-            thread->tokenStream += c->coinCount;
-            
+            EmojicodeCoin variableCount = consumeCoin(thread);
+            EmojicodeCoin coinCount = consumeCoin(thread);
+            EmojicodeCoin *tokenStream = thread->tokenStream;
+            thread->tokenStream += coinCount;
             EmojicodeCoin argumentCount = consumeCoin(thread);
-            c->argumentCount = argumentCount;
+            EmojicodeCoin capturedVariablesCount = consumeCoin(thread);
+            EmojicodeCoin *stackMap = thread->tokenStream;
+            thread->tokenStream += *stackMap + 1;
             
+            //The captured variables are allocated first, the GC must never see a closure without them
+            stackPush(stackGetThisContext(thread), 1, 0, thread);
+            stackSetVariable(0, somethingObject(newArray(sizeof(Something) * capturedVariablesCount)), thread);
+            Object *co = newObject(CL_CLOSURE);
+            Object *capturedVariables = stackGetVariable(0, thread).object;
             stackPop(thread);
             
-            c->capturedVariablesCount = consumeCoin(thread);
-            
-            Object *capturedVariables = newArray(sizeof(Something) * c->capturedVariablesCount);
+            Closure *c = objectValue(co);
+            c->variableCount = variableCount;
+            c->coinCount = coinCount;
+            c->tokenStream = tokenStream;
+            c->argumentCount = argumentCount;
+            c->capturedVariablesCount = capturedVariablesCount;
+            c->stackMap = stackMap;
             c->capturedVariables = capturedVariables;
             
-            Something *t = capturedVariables->value;
+            Something *t = objectValue(capturedVariables);
             for (uint_fast8_t i = 0; i < c->capturedVariablesCount; i++) {
                 t[i] = stackGetVariable(i, thread);
             }
@@ -830,7 +875,7 @@ Something parse(EmojicodeCoin coin, Thread *thread){
         case 0x72: {
             stackPush(parse(consumeCoin(thread), thread), 0, 0, thread);
             Object *cmco = newObject(CL_CAPTURED_FUNCTION_CALL);
-            CapturedFunctionCall *cmc = cmco->value;
+            CapturedFunctionCall *cmc = objectValue(cmco);
             
             EmojicodeCoin vti = consumeCoin(thread);
             cmc->function = stackGetThisObject(thread)->class->methodsVtable[vti];
@@ -841,7 +886,7 @@ Something parse(EmojicodeCoin coin, Thread *thread){
         case 0x73: {
             stackPush(parse(consumeCoin(thread), thread), 0, 0, thread);
             Object *cmco = newObject(CL_CAPTURED_FUNCTION_CALL);
-            CapturedFunctionCall *cmc = cmco->value;
+            CapturedFunctionCall *cmc = objectValue(cmco);
             
             EmojicodeCoin vti = consumeCoin(thread);
             cmc->function = stackGetThisContext(thread).eclass->methodsVtable[vti];
@@ -852,7 +897,7 @@ Something parse(EmojicodeCoin coin, Thread *thread){
         case 0x74: {
             stackPush(parse(consumeCoin(thread), thread), 0, 0, thread);
             Object *cmco = newObject(CL_CAPTURED_FUNCTION_CALL);
-            CapturedFunctionCall *cmc = cmco->value;
+            CapturedFunctionCall *cmc = objectValue(cmco);
             
             EmojicodeCoin vti = consumeCoin(thread);
             cmc->function = functionTable[vti];
@@ -860,6 +905,25 @@ Something parse(EmojicodeCoin coin, Thread *thread){
             stackPop(thread);
             return somethingObject(cmco);
         }
+        case 0x75: { //MARK: A method call captured and called at once, no captured function call is created
+            EmojicodeCoin kind = consumeCoin(thread);
+            Something callee = parse(consumeCoin(thread), thread);
+            EmojicodeCoin vti = consumeCoin(thread);
+            
+            Function *function;
+            switch (kind) {
+                case 0x72:
+                    function = callee.object->class->methodsVtable[vti];
+                    break;
+                case 0x73:
+                    function = callee.eclass->methodsVtable[vti];
+                    break;
+                default:
+                    function = functionTable[vti];
+                    break;
+            }
+            return performFunction(function, callee, thread);
+        }
     }
     return NOTHINGNESS;
 }
@@ -871,6 +935,27 @@ int main(int argc, char *argv[]) {
     if ((ppath = getenv("EMOJICODE_PACKAGES_PATH"))) {
         packageDirectory = ppath;
     }
+    const char *collector;
+    if ((collector = getenv("EMOJICODE_GC"))) {
+        if (strcmp(collector, "compact") == 0) {
+            compactingGC = true;
+        }
+        else if (strcmp(collector, "incremental") == 0) {
+            incrementalGC = true;
+        }
+    }
+    if (getenv("EMOJICODE_GC_STATS")) {
+        atexit(printGCStatistics);
+    }
+    installHeapSnapshotSignalHandler();
+    const char *sampleInterval;
+    if ((sampleInterval = getenv("EMOJICODE_ALLOCATION_PROFILE"))) {
+        allocationSampleInterval = strtoul(sampleInterval, NULL, 10);
+        if (!allocationSampleInterval) {
+            allocationSampleInterval = 512 * 1024;
+        }
+        atexit(printAllocationProfile);
+    }
     
     setlocale(LC_CTYPE, "de_DE.UTF-8");
     if (argc < 2){
@@ -882,7 +967,15 @@ int main(int argc, char *argv[]) {
        error("File couldn't be opened.");
     }
     
-    Thread *mainThread = allocateThread();
+    //The VM stack may grow as large as the native stack, which is limited by the process’s resource limit
+    struct rlimit stackLimit;
+    bool limitedStack = getrlimit(RLIMIT_STACK, &stackLimit) == 0 && stackLimit.rlim_cur != RLIM_INFINITY;
+    Thread *mainThread = allocateThread(limitedStack ? stackLimit.rlim_cur : 0);
+    if (limitedStack) {
+        stackSetNativeStackSize(stackLimit.rlim_cur, mainThread);
+    }
+    currentThread = mainThread;
+    disallowGCAndPauseIfNeeded();
     
     allocateHeap();
     
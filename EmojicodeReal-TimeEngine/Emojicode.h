@@ -11,6 +11,7 @@
 
 #define _GNU_SOURCE
 #include "EmojicodeAPI.h"
+#include <stdatomic.h>
 
 //MARK: Stack
 
@@ -19,6 +20,11 @@ struct StackFrame {
     uint8_t variableCount;
     void *returnPointer;
     void *returnFutureStack;
+    /**
+     * The stack map of the function executing in this frame: The number of variables that may contain an object
+     * reference followed by their indices. If @c NULL, all variables are scanned.
+     */
+    EmojicodeCoin *stackMap;
 };
 
 struct StackState {
@@ -26,12 +32,41 @@ struct StackState {
     Byte *stack;
 };
 
-/** Try to allocate a thread and a stack. */
-Thread* allocateThread(void);
+typedef struct StackSegment StackSegment;
 
-/** Removes the thread from the linked list. */
+/** The size a thread’s VM stack may grow to if no other size was requested. */
+#ifndef defaultMaxStackSize
+#define defaultMaxStackSize (8 * 1024 * 1024)
+#endif
+
+/**
+ * Try to allocate a thread and a stack, which can grow up to @c maxStackSize bytes.
+ * Pass 0 to use @c defaultMaxStackSize.
+ */
+Thread* allocateThread(size_t maxStackSize);
+
+/** Removes the thread from the linked list and frees it. */
 void removeThread(Thread *);
 
+/** Sets up an empty VM stack for the thread. */
+void stackInitialize(size_t maxSize, Thread *thread);
+/**
+ * Makes reserving a stack frame fail with a stack overflow error before the native stack, which must be @c size
+ * bytes large, overflows. Must be called on the thread’s own native thread as early as possible.
+ */
+void stackSetNativeStackSize(size_t size, Thread *thread);
+/** Frees all segments of the thread’s VM stack. */
+void stackFree(Thread *thread);
+/**
+ * Like @c stackReserveFrame but leaves the first @c argCount variables uninitialized. The caller must set them before
+ * anything is allocated. @c stackMap may be @c NULL.
+ */
+Something* stackReserveArgumentFrame(Something thisContext, uint8_t variableCount, uint8_t argCount,
+                                     EmojicodeCoin *stackMap, Thread *thread);
+/** Like @c stackPush but the garbage collector only scans the variables listed in @c stackMap. */
+void stackPushFunction(Something thisContext, uint8_t variableCount, uint8_t argCount, EmojicodeCoin *stackMap,
+                       Thread *thread);
+
 /** Marks all variables on the stack */
 void stackMark(Thread *);
 
@@ -40,36 +75,138 @@ void stackMark(Thread *);
  * Not thread-safe!
  */
 void gc();
+/** Stops all other threads and runs a GC cycle. */
+void collectGarbageNow(void);
+
+/** The thread is executing and must reach a safepoint before the GC can run. */
+#define THREAD_RUNNING 0
+/** The thread is parked at a safepoint or in a region that allows GC and does not touch the heap. */
+#define THREAD_SAFE 1
 
 struct Thread {
     EmojicodeCoin *tokenStream;
     Something returnValue;
     bool returned;
+    /** Set by @c initializerFailed. */
+    bool initializerFailed;
     
+    /** The segment of the VM stack in which frames are currently reserved. */
+    StackSegment *stackSegment;
+    /** The lowest address of the current segment. */
     Byte *stackLimit;
+    /** The bottom of the first segment, which terminates the chain of stack frames. */
     Byte *stackBottom;
     Byte *stack;
     Byte *futureStack;
+    /** The combined size of the segments in use, which must not exceed @c maxStackSize. */
+    size_t stackSize;
+    size_t maxStackSize;
+    /** The lowest address the native stack may reach or 0 if the native stack is not checked. */
+    uintptr_t nativeStackLimit;
+    
+    /**
+     * Either @c THREAD_RUNNING or @c THREAD_SAFE. Only the thread itself changes its state, a thread that wants to
+     * collect garbage waits for it to become safe.
+     */
+    _Atomic uint32_t state;
     
     Thread *threadBefore;
     Thread *threadAfter;
 };
 
 extern Thread *lastThread;
+/** The thread running on the current OS thread. */
+extern _Thread_local Thread *currentThread;
 extern int threads;
+/** Protects the list of threads. Held by the collecting thread for the whole GC cycle. */
+extern pthread_mutex_t threadListMutex;
+
+/** Blocks until @c address is woken up if it still contains @c value. May return spuriously. */
+void futexWait(_Atomic uint32_t *address, uint32_t value);
+/** Wakes all threads waiting on @c address. */
+void futexWake(_Atomic uint32_t *address);
+/** Wakes one of the threads waiting on @c address. */
+void futexWakeOne(_Atomic uint32_t *address);
 
 //MARK: VM
 
 Byte *currentHeap;
 Byte *otherHeap;
+/**
+ * Whether the heap is collected by a sliding mark-compact collector, which can use the whole heap, instead of the
+ * copying collector, which uses only one half at a time. Must be set before @c allocateHeap is called.
+ */
+extern bool compactingGC;
+/**
+ * Whether the heap is collected by an incremental mark-sweep collector, which marks while the program runs and does
+ * not move objects. Must be set before @c allocateHeap is called.
+ */
+extern bool incrementalGC;
 void allocateHeap(void);
 
 #ifndef heapSize
 #define heapSize (512 * 1000 * 1000) //512 MB
 #endif
 
+//MARK: GC statistics
+
+typedef struct {
+    /** The number of GC cycles run. */
+    uint64_t collections;
+    /** The number of times all threads were stopped for the GC. Unless @c incrementalGC is set once per cycle. */
+    uint64_t pauses;
+    /** The total time in nanoseconds all threads were stopped for the GC. */
+    uint64_t totalPause;
+    /** The longest time in nanoseconds all threads were stopped for the GC at once. */
+    uint64_t maxPause;
+    /** The number of bytes allocated, including the large object space. */
+    uint64_t bytesAllocated;
+    /** The number of bytes copied or, if @c compactingGC is set, moved by the GC. Always 0 if @c incrementalGC is set. */
+    uint64_t bytesCopied;
+    /** The highest number of bytes in use in the heap and the large object space at once. */
+    uint64_t heapHighWaterMark;
+    /** The number of bytes currently mapped for the large object space. */
+    uint64_t largeObjectSpaceSize;
+} GCStatistics;
+
+/** Returns a consistent copy of the GC statistics. */
+extern GCStatistics gcStatistics(void);
+/** Returns the pause in nanoseconds that @c percentile percent of all GC pauses did not exceed or 0 if no GC ran. */
+extern uint64_t gcPausePercentile(double percentile);
+/** Prints the GC statistics and the allocations per class to @c stderr. */
+extern void printGCStatistics(void);
+
+//MARK: Allocation profiler
+
+/** Every time this number of bytes has been allocated, the allocation is sampled. 0 if the profiler is disabled. */
+extern size_t allocationSampleInterval;
+/** Makes the token stream of a function known to the profiler so that samples can be attributed to it. */
+extern void allocationProfilerRegisterBlock(EmojicodeCoin *tokenStream, uint32_t tokenCount, EmojicodeChar className,
+                                            EmojicodeChar name, bool initializer);
+/** Must only be called while holding the allocation mutex and if @c allocationSampleInterval is not 0. */
+extern void allocationProfilerRecord(Class *class, size_t size);
+/** Prints the allocation sites responsible for the most bytes to @c stderr. */
+extern void printAllocationProfile(void);
+
+//MARK: Heap snapshots
+
+/**
+ * Runs a GC cycle and writes every live object and every reference found to the file at @c path.
+ * The format is line based: @c "N <address> <size> <class name>" for objects and @c "E <address> <address>"
+ * for references where the address @c 0 stands for the roots. Returns false if the file couldn’t be opened.
+ */
+extern bool heapSnapshot(const char *path);
+/** Makes @c SIGUSR1 write a heap snapshot to the current directory at the next safepoint. */
+extern void installHeapSnapshotSignalHandler(void);
+
+/** Arrays of at least this size (including the object header) are allocated in the large object space and never copied by the GC. */
+#ifndef largeObjectThreshold
+#define largeObjectThreshold (64 * 1024) //64 KB
+#endif
+
 /** The class table */
 Class **classTable;
+uint_fast16_t classCount;
 Function **functionTable;
 
 uint_fast16_t stringPoolCount;
@@ -94,8 +231,14 @@ struct Class {
     /** The class’s superclass */
     struct Class *superclass;
     
-    /** The number of instance variables. */
-    uint16_t instanceVariableCount;
+    /** The size of the instance variable area, which follows the value area. */
+    uint32_t instanceVariablesSize;
+    /** The offsets of the instance variables stored as @c Something, inclusive those of the superclasses. */
+    uint32_t *somethingVariables;
+    uint32_t somethingVariableCount;
+    /** The offsets of the instance variables stored as object references, inclusive those of the superclasses. */
+    uint32_t *objectVariables;
+    uint32_t objectVariableCount;
     uint16_t methodCount;
     uint16_t initializerCount;
     
@@ -107,6 +250,11 @@ struct Class {
     
     size_t size;
     size_t valueSize;
+    
+    /** The class’s name as given in the bytecode file or 0 for internal classes. */
+    EmojicodeChar name;
+    /** The number of instances allocated. Protected by the allocation mutex. */
+    uint64_t allocations;
 };
 
 struct Function {
@@ -125,6 +273,8 @@ struct Function {
             EmojicodeCoin *tokenStream;
             /** The number of tokens */
             uint32_t tokenCount;
+            /** The stack map, see @c StackFrame. */
+            EmojicodeCoin *stackMap;
         };
     };
 };
@@ -145,6 +295,8 @@ struct InitializerFunction {
             EmojicodeCoin *tokenStream;
             /** The number of tokens */
             uint32_t tokenCount;
+            /** The stack map, see @c StackFrame. */
+            EmojicodeCoin *stackMap;
         };
     };
 };
@@ -162,8 +314,73 @@ typedef struct {
     uint8_t variableCount;
     Object *capturedVariables;
     Something thisContext;
+    /** The stack map, which is located in the token stream. */
+    EmojicodeCoin *stackMap;
 } Closure;
 
+//MARK: Task pools
+
+typedef struct TaskPool TaskPool;
+
+/** The value of a 🎫, a task submitted to a 🏊. */
+typedef struct {
+    TaskPool *pool;
+    /** The callable to run or @c NULL once the task has been run. */
+    Object *callable;
+    _Atomic bool finished;
+} Task;
+
+/** Marks the tasks that were submitted to a pool but not yet taken by a worker. Called by the GC. */
+void taskPoolsMark(void);
+/** Runs @c callable on a worker of the 🏊 @c pool without creating a 🎫. */
+void taskPoolSubmitCallable(Object *pool, Object *callable);
+
+/**
+ * Runs chunk @c chunk of a job started with @c taskPoolRunChunks. @c objects are the objects passed to
+ * @c taskPoolRunChunks, which must be read again after anything that may cause a GC cycle.
+ */
+typedef void (*TaskPoolChunkFunction)(Object **objects, void *context, size_t chunk, Thread *thread);
+/** Returns how many chunks @c itemCount items should be split into to be processed by the 🏊 @c pool. */
+size_t taskPoolChunkCount(Object *pool, size_t itemCount);
+/**
+ * Calls @c function for the chunks @c 0 to @c chunkCount - 1 on the calling thread and on the workers of the 🏊
+ * @c pool and returns once all chunks have been run. @c objects are kept alive while the chunks run and are updated
+ * to where the GC moved them before the function returns.
+ */
+void taskPoolRunChunks(Object *pool, size_t chunkCount, TaskPoolChunkFunction function, Object **objects,
+                       size_t objectCount, void *context, Thread *thread);
+/** Shuts the pool down. The workers exit after they have run all remaining tasks. */
+void taskPoolDeinitialize(void *value);
+void taskMark(Object *self);
+FunctionFunctionPointer taskPoolMethodForName(EmojicodeChar name);
+InitializerFunctionFunctionPointer taskPoolInitializerForName(EmojicodeChar name);
+FunctionFunctionPointer taskMethodForName(EmojicodeChar name);
+InitializerFunctionFunctionPointer taskInitializerForName(EmojicodeChar name);
+
+//MARK: Channels
+
+typedef struct Channel Channel;
+
+void channelMark(Object *self);
+void channelDeinitialize(void *value);
+FunctionFunctionPointer channelMethodForName(EmojicodeChar name);
+InitializerFunctionFunctionPointer channelInitializerForName(EmojicodeChar name);
+
+//MARK: Coroutines
+
+typedef struct Coroutine Coroutine;
+
+void coroutineDeinitialize(void *value);
+FunctionFunctionPointer coroutineMethodForName(EmojicodeChar name);
+InitializerFunctionFunctionPointer coroutineInitializerForName(EmojicodeChar name);
+
+//MARK: Synchronization
+
+/** Frees the state of a 🚦, 🔔 or 🚥. */
+void synchronizationDeinitialize(void *value);
+FunctionFunctionPointer synchronizationMethodForName(EmojicodeChar cl, EmojicodeChar name);
+InitializerFunctionFunctionPointer synchronizationInitializerForName(EmojicodeChar cl);
+
 //MARK: Parsing
 
 EmojicodeCoin consumeCoin(Thread *thread);
@@ -177,12 +394,23 @@ _Noreturn void error(char *err, ...);
 
 //MARK: Object
 
-Something objectGetVariable(Object *o, uint8_t index);
+/** Removes an object whose native initializer failed from the objects that need finalization. */
+void discardFailedObject(Object *object);
+/**
+ * Accounts for @c size bytes that were allocated outside the heap and are freed by a deinitializer, so that they
+ * cause GC cycles like large objects do. This function may invoke the GC.
+ */
+void registerExternalAllocation(size_t size);
+/**
+ * Returns the instance variable at @c offset in the instance variable area.
+ * @param kind How the variable is stored. One of the @c IV_ constants.
+ */
+Something objectGetVariable(Object *o, uint8_t kind, uint32_t offset);
 
-void objectSetVariable(Object *o, uint8_t index, Something value);
+void objectSetVariable(Object *o, uint8_t kind, uint32_t offset, Something value);
 
-void objectDecrementVariable(Object *o, uint8_t index);
-void objectIncrementVariable(Object *o, uint8_t index);
+void objectDecrementVariable(Object *o, uint8_t kind, uint32_t offset);
+void objectIncrementVariable(Object *o, uint8_t kind, uint32_t offset);
 
 
 //MARK: Reading bytecode file
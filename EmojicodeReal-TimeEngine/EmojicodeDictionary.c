@@ -23,11 +23,11 @@ EmojicodeDictionaryHash fnv64(const char *k, size_t length) {
 
 EmojicodeDictionaryHash dictionaryHash(EmojicodeDictionary *dict, Object *key) {
     #define hashString(keyString) fnv64((char*)characters(keyString), ((keyString)->length) * sizeof(EmojicodeChar))
-    return hashString((String *) key->value);
+    return hashString((String *) objectValue(key));
 }
 
 bool dictionaryKeyEqual(EmojicodeDictionary *dict, Object *key1, Object *key2) {
-    return stringEqual((String *) key1->value, (String *) key2->value);
+    return stringEqual((String *) objectValue(key1), (String *) objectValue(key2));
 }
 
 bool dictionaryKeyHashEqual(EmojicodeDictionary *dict, EmojicodeDictionaryHash hash1, EmojicodeDictionaryHash hash2, Object *key1, Object *key2) {
@@ -40,17 +40,17 @@ EmojicodeDictionaryNode* dictionaryGetNode(EmojicodeDictionary *dict, EmojicodeD
     Object** bucko;
     size_t n = 0;
     if (dict->buckets != NULL) {
-        bucko = (Object**) dict->buckets->value;
+        bucko = (Object**) objectValue(dict->buckets);
         if ((n = dict->bucketsCounter) > 0) {
             Object *firsto = bucko[hash & (n - 1)];
             if (firsto != NULL) {
-                e = firsto->value;
+                e = objectValue(firsto);
                 if (dictionaryKeyHashEqual(dict, hash, e->hash, key, e->key)) {
                     return e;
                 }
                 Object *eo;
                 while ((eo = e->next)) {
-                    e = eo->value;
+                    e = objectValue(eo);
                     if (dictionaryKeyHashEqual(dict, hash, e->hash, key, e->key)) {
                         return e;
                     }
@@ -65,7 +65,7 @@ EmojicodeDictionaryNode* dictionaryGetNode(EmojicodeDictionary *dict, EmojicodeD
 Object* dictionaryNewNode(Object **dicto, EmojicodeDictionaryHash hash, Object *key, Something value, Object *next, Thread *thread){
     stackPush(somethingObject(*dicto), 0, 0, thread);
     Object *nodeo = newArray(sizeof(EmojicodeDictionaryNode));
-    EmojicodeDictionaryNode *node = (EmojicodeDictionaryNode *) nodeo->value;
+    EmojicodeDictionaryNode *node = (EmojicodeDictionaryNode *) objectValue(nodeo);
     *dicto = stackGetThisObject(thread);
     stackPop(thread);
     
@@ -78,7 +78,7 @@ Object* dictionaryNewNode(Object **dicto, EmojicodeDictionaryHash hash, Object *
 
 /** @warning GC-Invoking */
 Object* dictionaryResize(Object *dicto, Thread *thread) {
-    EmojicodeDictionary *dict = dicto->value;
+    EmojicodeDictionary *dict = objectValue(dicto);
 
     Object *oldBuckoo = dict->buckets;
     size_t oldCap = (oldBuckoo == NULL) ? 0 : dict->bucketsCounter;
@@ -110,20 +110,20 @@ Object* dictionaryResize(Object *dicto, Thread *thread) {
     stackPush(somethingObject(dicto), 0, 0, thread);
     Object *newBuckoo = newArray(newCap * sizeof(Object *));
     dicto = stackGetThisObject(thread);
-    dict = dicto->value;
+    dict = objectValue(dicto);
     stackPop(thread);
     
     dict->buckets = newBuckoo;
     dict->nextThreshold = newThr;
     dict->bucketsCounter = newCap;
     
-    Object **newBucko = newBuckoo->value;
+    Object **newBucko = objectValue(newBuckoo);
     if (oldBuckoo != NULL) {
         for (int j = 0; j < oldCap; ++j) {
-            Object **oldBucko = oldBuckoo->value;
+            Object **oldBucko = objectValue(oldBuckoo);
             Object *eo = oldBucko[j];
             if (eo != NULL) {
-                EmojicodeDictionaryNode *e = eo->value;
+                EmojicodeDictionaryNode *e = objectValue(eo);
                 oldBucko[j] = NULL;
                 if (e->next == NULL) {
                     newBucko[e->hash & (newCap - 1)] = eo;
@@ -133,14 +133,14 @@ Object* dictionaryResize(Object *dicto, Thread *thread) {
                     Object *hiHeado = NULL, *hiTailo = NULL;
                     Object *nexto;
                     do {
-                        e = eo->value;
+                        e = objectValue(eo);
                         nexto = e->next;
                         if ((e->hash & oldCap) == 0) {
                             if (loTailo == NULL) {
                                 loHeado = eo;
                             }
                             else {
-                                EmojicodeDictionaryNode *loTail = loTailo->value;
+                                EmojicodeDictionaryNode *loTail = objectValue(loTailo);
                                 loTail->next = eo;
                             }
                             loTailo = eo;
@@ -150,7 +150,7 @@ Object* dictionaryResize(Object *dicto, Thread *thread) {
                                 hiHeado = eo;
                             }
                             else {
-                                EmojicodeDictionaryNode *hiTail = hiTailo->value;
+                                EmojicodeDictionaryNode *hiTail = objectValue(hiTailo);
                                 hiTail->next = eo;
                             }
                             hiTailo = eo;
@@ -158,12 +158,12 @@ Object* dictionaryResize(Object *dicto, Thread *thread) {
                     } while ((eo = nexto) != NULL);
                     
                     if (loTailo != NULL) {
-                        EmojicodeDictionaryNode *loTail = loTailo->value;
+                        EmojicodeDictionaryNode *loTail = objectValue(loTailo);
                         loTail->next = NULL;
                         newBucko[j] = loHeado;
                     }
                     if(hiTailo != NULL) {
-                        EmojicodeDictionaryNode *hiTail = hiTailo->value;
+                        EmojicodeDictionaryNode *hiTail = objectValue(hiTailo);
                         hiTail->next = NULL;
                         newBucko[j + oldCap] = hiHeado;
                     }
@@ -175,28 +175,28 @@ Object* dictionaryResize(Object *dicto, Thread *thread) {
 }
 
 void dictionaryPutVal(Object *dicto, Object *key, Something value, Thread *thread) {
-    EmojicodeDictionaryHash hash = dictionaryHash(dicto->value, key);
+    EmojicodeDictionaryHash hash = dictionaryHash(objectValue(dicto), key);
     
-    EmojicodeDictionary *dict = dicto->value;
+    EmojicodeDictionary *dict = objectValue(dicto);
     
     if (dict->buckets == NULL || dict->bucketsCounter == 0) {
         dicto = dictionaryResize(dicto, thread);
-        dict = dicto->value;
+        dict = objectValue(dicto);
     }
     
     Object **bucko;
     size_t n = 0, i = 0;
-    bucko = dict->buckets->value;
+    bucko = objectValue(dict->buckets);
     n = dict->bucketsCounter;
     
     Object *po;
     
     if ((po = bucko[i = (hash & (n - 1))]) == NULL) {
         bucko[i] = dictionaryNewNode(&dicto, hash, key, value, NULL, thread);
-        dict = dicto->value;
+        dict = objectValue(dicto);
     }
     else {
-        EmojicodeDictionaryNode *p = po->value;
+        EmojicodeDictionaryNode *p = objectValue(po);
         Object *eo = NULL;
         if (dictionaryKeyHashEqual(dict, hash, p->hash, key, p->key)) {
             eo = po;
@@ -205,12 +205,12 @@ void dictionaryPutVal(Object *dicto, Object *key, Something value, Thread *threa
             for (int binCount = 0; ; ++binCount) {
                 if (p->next == NULL) {
                     p->next = dictionaryNewNode(&dicto, hash, key, value, NULL, thread);
-                    dict = dicto->value;
+                    dict = objectValue(dicto);
                     eo = NULL;
                     break;
                 }
                 eo = p->next;
-                EmojicodeDictionaryNode *e = eo->value;
+                EmojicodeDictionaryNode *e = objectValue(eo);
                 
                 if (dictionaryKeyHashEqual(dict, hash, e->hash, key, e->key)) {
                     break;
@@ -219,24 +219,25 @@ void dictionaryPutVal(Object *dicto, Object *key, Something value, Thread *threa
             }
         }
         if (eo != NULL) { // existing mapping for key
-            EmojicodeDictionaryNode *e = eo->value;
+            EmojicodeDictionaryNode *e = objectValue(eo);
+            writeBarrierSomething(e->value);
             e->value = value;
             return;
         }
     }
     if(++(dict->size) > dict->nextThreshold) {
         dicto = dictionaryResize(dicto, thread);
-        dict = dicto->value;
+        dict = objectValue(dicto);
     }
 }
 
 EmojicodeDictionaryNode* dictionaryRemoveNode(EmojicodeDictionary *dict, EmojicodeDictionaryHash hash, Object *key, Thread *thread) {
     size_t n = 0, index = 0;
     if (dict->buckets != NULL && (n = dict->bucketsCounter) > 0) {
-        Object **bucko = dict->buckets->value;
+        Object **bucko = objectValue(dict->buckets);
         Object *po = bucko[index = hash & (n - 1)];
         if (po != NULL) {
-            EmojicodeDictionaryNode *p = po->value;
+            EmojicodeDictionaryNode *p = objectValue(po);
             EmojicodeDictionaryNode *node = NULL;
             if (dictionaryKeyHashEqual(dict, hash, p->hash, key, p->key)) {
                 node = p;
@@ -244,7 +245,7 @@ EmojicodeDictionaryNode* dictionaryRemoveNode(EmojicodeDictionary *dict, Emojico
             else {
                 Object *nexto = p->next;
                 while (nexto) {
-                    EmojicodeDictionaryNode *e = nexto->value;
+                    EmojicodeDictionaryNode *e = objectValue(nexto);
                     if (dictionaryKeyHashEqual(dict, hash, e->hash, key, e->key)) {
                         node = e;
                         break;
@@ -254,6 +255,9 @@ EmojicodeDictionaryNode* dictionaryRemoveNode(EmojicodeDictionary *dict, Emojico
                 }
             }
             if(node != NULL) {
+                writeBarrier(node == p ? po : p->next);
+                writeBarrier(node->key);
+                writeBarrierSomething(node->value);
                 if (node == p) {
                     bucko[index] = node->next;
                 }
@@ -280,6 +284,17 @@ bool dictionaryContains(EmojicodeDictionary *dict, Object *key) {
 
 size_t dictionaryClear(EmojicodeDictionary *dict) {
     size_t sizeBefore = dict->size;
+    if (incrementalMarking && dict->buckets != NULL) {
+        Object **buckets = objectValue(dict->buckets);
+        for (size_t i = 0; i < dict->bucketsCounter; i++) {
+            for (Object *eo = buckets[i]; eo != NULL; eo = ((EmojicodeDictionaryNode *)objectValue(eo))->next) {
+                EmojicodeDictionaryNode *e = objectValue(eo);
+                writeBarrier(eo);
+                writeBarrier(e->key);
+                writeBarrierSomething(e->value);
+            }
+        }
+    }
     dict->loadFactor = DICTIONARY_DEFAULT_LOAD_FACTOR;
     dict->size = 0;
     dict->buckets = NULL;
@@ -295,29 +310,29 @@ Something dictionaryKeys(Object *dicto, Thread *thread) {
         stackSetVariable(0, somethingObject(listObject), thread);
         
         dicto = stackGetThisObject(thread);
-        EmojicodeDictionary *dict = dicto->value;
+        EmojicodeDictionary *dict = objectValue(dicto);
         
-        List *newList = listObject->value;
+        List *newList = objectValue(listObject);
         newList->capacity = dict->size;
-        Object *items = newArray(sizeof(Something) * dict->size);
-        ((List *)stackGetVariable(0, thread).object->value)->items = items;
+        Object *items = newListItems(dict->size);
+        ((List *)objectValue(stackGetVariable(0, thread).object))->items = items;
     }
     
     dicto = stackGetThisObject(thread);
-    EmojicodeDictionary *dict = dicto->value;
+    EmojicodeDictionary *dict = objectValue(dicto);
     
     for (size_t i = 0; i < dict->bucketsCounter; i++) {
-        Object **bucko = (Object **)dict->buckets->value;
+        Object **bucko = (Object **)objectValue(dict->buckets);
         Object *nodeo = bucko[i];
         while (nodeo) {
             stackSetVariable(1, somethingObject(nodeo), thread);
             
-            listAppend(stackGetVariable(0, thread).object, somethingObject(((EmojicodeDictionaryNode *) nodeo->value)->key), thread);
+            listAppend(stackGetVariable(0, thread).object, somethingObject(((EmojicodeDictionaryNode *) objectValue(nodeo))->key), thread);
 
-            nodeo = ((EmojicodeDictionaryNode *) stackGetVariable(1, thread).object->value)->next;
+            nodeo = ((EmojicodeDictionaryNode *) objectValue(stackGetVariable(1, thread).object))->next;
             
             dicto = stackGetThisObject(thread);
-            dict = dicto->value;
+            dict = objectValue(dicto);
         }
     }
     
@@ -328,24 +343,24 @@ Something dictionaryKeys(Object *dicto, Thread *thread) {
 }
 
 void dictionaryInit(Thread *thread) {
-    EmojicodeDictionary *dict = stackGetThisObject(thread)->value;
+    EmojicodeDictionary *dict = objectValue(stackGetThisObject(thread));
     dict->loadFactor = DICTIONARY_DEFAULT_LOAD_FACTOR;
 }
 
 void dictionaryMark(Object *object) {
-    EmojicodeDictionary *dict = object->value;
+    EmojicodeDictionary *dict = objectValue(object);
     
     if(dict->buckets == NULL){
         return;
     }
     mark(&dict->buckets);
     
-    Object **buckets = dict->buckets->value;
+    Object **buckets = objectValue(dict->buckets);
     for (size_t i = 0; i < dict->bucketsCounter; i++) {
         Object **eo = &buckets[i];
         while (*(eo)) {
             mark(eo);
-            EmojicodeDictionaryNode *e = (*eo)->value;
+            EmojicodeDictionaryNode *e = objectValue(*eo);
             mark(&(e->key));
             if (isRealObject(e->value)){
                 mark(&(e->value.object));
@@ -368,7 +383,7 @@ static Something bridgeDictionarySet(Thread *thread) {
 
 static Something bridgeDictionaryGet(Thread *thread) {
     Object *key = stackGetVariable(0, thread).object;
-    EmojicodeDictionaryNode *node = dictionaryGetNode(stackGetThisObject(thread)->value, dictionaryHash(stackGetThisObject(thread)->value, key), key);
+    EmojicodeDictionaryNode *node = dictionaryGetNode(objectValue(stackGetThisObject(thread)), dictionaryHash(objectValue(stackGetThisObject(thread)), key), key);
     if(node == NULL){
         return NOTHINGNESS;
     }
@@ -378,7 +393,7 @@ static Something bridgeDictionaryGet(Thread *thread) {
 }
 
 static Something bridgeDictionaryRemove(Thread *thread) {
-    dictionaryRemove(stackGetThisObject(thread)->value, stackGetVariable(0, thread).object, thread);
+    dictionaryRemove(objectValue(stackGetThisObject(thread)), stackGetVariable(0, thread).object, thread);
     return NOTHINGNESS;
 }
 
@@ -387,16 +402,16 @@ static Something bridgeDictionaryKeys(Thread *thread) {
 }
 
 static Something bridgeDictionaryClear(Thread *thread) {
-    return somethingInteger(dictionaryClear(stackGetThisObject(thread)->value));
+    return somethingInteger(dictionaryClear(objectValue(stackGetThisObject(thread))));
 }
 
 static Something bridgeDictionaryContains(Thread *thread) {
     Object *key = stackGetVariable(0, thread).object;
-    return somethingBoolean(dictionaryContains(stackGetThisObject(thread)->value, key));
+    return somethingBoolean(dictionaryContains(objectValue(stackGetThisObject(thread)), key));
 }
 
 static Something bridgeDictionarySize(Thread *thread) {
-    return somethingInteger(((EmojicodeDictionary *) stackGetThisObject(thread)->value)->size);
+    return somethingInteger(((EmojicodeDictionary *) objectValue(stackGetThisObject(thread)))->size);
 }
 
 void bridgeDictionaryInit(Thread *thread) {
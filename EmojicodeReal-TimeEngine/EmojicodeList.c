@@ -6,67 +6,106 @@
 //  Copyright (c) 2015 Theo Weidmann. All rights reserved.
 //
 
+#include "Emojicode.h"
 #include "EmojicodeList.h"
 #include "EmojicodeString.h"
 
 #include <string.h>
 
-#define items(list) ((Something *)(list)->items->value)
+/**
+ * The items are not stored as an array of @c Something, which would waste seven bytes of padding per item.
+ * Instead the items array contains @c capacity 8-byte payloads followed by @c capacity type bytes.
+ */
+typedef union {
+    EmojicodeInteger raw;
+    double doubl;
+    Object *object;
+    Class *eclass;
+} ListValue;
 
-void expandListSize(Thread *thread){
-#define initialSize 7
-    List *list = stackGetThisObject(thread)->value;
-    if (list->capacity == 0) {
-        Object *object = newArray(sizeof(Something) * initialSize);
-        list = stackGetThisObject(thread)->value;
-        list->items = object;
-        list->capacity = initialSize;
-    }
-    else {
-        size_t newSize = list->capacity + (list->capacity >> 1);
-        Object *object = resizeArray(list->items, sizeCalculationWithOverflowProtection(newSize, sizeof(Something)));
-        list = stackGetThisObject(thread)->value;
+#define listItemSize (sizeof(ListValue) + sizeof(uint8_t))
+#define values(list) ((ListValue *)objectValue((list)->items))
+#define types(list) ((uint8_t *)(values(list) + (list)->capacity))
+
+static inline Something listItem(List *list, size_t i){
+    Something sth = {types(list)[i]};
+    sth.raw = values(list)[i].raw;
+    return sth;
+}
+
+static inline void listSetItem(List *list, size_t i, Something sth){
+    types(list)[i] = sth.type;
+    values(list)[i].raw = sth.raw;
+}
+
+/** Moves the items at @c from to @c to. The ranges may overlap. */
+static void listMoveItems(List *list, size_t to, size_t from, size_t count){
+    memmove(values(list) + to, values(list) + from, count * sizeof(ListValue));
+    memmove(types(list) + to, types(list) + from, count);
+}
+
+Object* newListItems(size_t capacity){
+    return newArray(sizeCalculationWithOverflowProtection(capacity, listItemSize));
+}
+
+/** Changes the capacity of the list, which must be this, to @c capacity, which must be greater. */
+static void listResize(Thread *thread, size_t capacity){
+    List *list = objectValue(stackGetThisObject(thread));
+    size_t oldCapacity = list->capacity;
+    if (oldCapacity == 0) {
+        Object *object = newListItems(capacity);
+        list = objectValue(stackGetThisObject(thread));
         list->items = object;
-        list->capacity = newSize;
+        list->capacity = capacity;
+        return;
     }
+    
+    Object *object = resizeArray(list->items, sizeCalculationWithOverflowProtection(capacity, listItemSize));
+    list = objectValue(stackGetThisObject(thread));
+    list->items = object;
+    list->capacity = capacity;
+    
+    //The type bytes were copied to where the new payloads begin
+    Byte *bytes = objectValue(object);
+    memmove(bytes + capacity * sizeof(ListValue), bytes + oldCapacity * sizeof(ListValue), oldCapacity);
+    memset(bytes + oldCapacity * sizeof(ListValue), 0, (capacity - oldCapacity) * sizeof(ListValue));
+    memset(bytes + capacity * sizeof(ListValue) + oldCapacity, 0, capacity - oldCapacity);
+}
+
+void expandListSize(Thread *thread){
+#define initialSize 7
+    List *list = objectValue(stackGetThisObject(thread));
+    listResize(thread, list->capacity == 0 ? initialSize : list->capacity + (list->capacity >> 1));
 #undef initialSize
 }
 
 void listEnsureCapacity(Thread *thread, size_t size) {
-    List *list = stackGetThisObject(thread)->value;
+    List *list = objectValue(stackGetThisObject(thread));
     if (list->capacity < size) {
-        Object *object;
-        if (list->capacity == 0) {
-            object = newArray(sizeCalculationWithOverflowProtection(size, sizeof(Something)));
-        }
-        else {
-            object = resizeArray(list->items, sizeCalculationWithOverflowProtection(size, sizeof(Something)));
-        }
-        list = stackGetThisObject(thread)->value;
-        list->items = object;
-        list->capacity = size;
+        listResize(thread, size);
     }
 }
 
 void listMark(Object *self){
-    List *list = self->value;
+    List *list = objectValue(self);
     if (list->items) {
         mark(&list->items); 
     }
     for (size_t i = 0; i < list->count; i++) {
-        if(isRealObject(items(list)[i]))
-           mark(&items(list)[i].object);
+        if (types(list)[i] == T_OBJECT && values(list)[i].object)
+           mark(&values(list)[i].object);
     }
 }
 
 void listAppend(Object *lo, Something o, Thread *thread){
-    stackPush(somethingObject(lo), 0, 0, thread);
-    List *list = lo->value;
+    stackPush(somethingObject(lo), 1, 0, thread);
+    stackSetVariable(0, o, thread);
+    List *list = objectValue(lo);
     if (list->capacity - list->count == 0) {
         expandListSize(thread);
     }
-    list = stackGetThisObject(thread)->value;
-    items(list)[list->count++] = o;
+    list = objectValue(stackGetThisObject(thread));
+    listSetItem(list, list->count++, stackGetVariable(0, thread));
     stackPop(thread);
 }
 
@@ -75,8 +114,9 @@ Something listPop(List *list){
         return NOTHINGNESS;
     }
     size_t index = --list->count;
-    Something v = items(list)[index];
-    items(list)[index] = NOTHINGNESS;
+    Something v = listItem(list, index);
+    writeBarrierSomething(v);
+    listSetItem(list, index, NOTHINGNESS);
     return v;
 }
 
@@ -87,8 +127,9 @@ bool listRemoveByIndex(List *list, EmojicodeInteger index){
     if (index < 0 || list->count <= index){
         return false;
     }
-    memmove(items(list) + index, items(list) + index + 1, sizeof(Something) * (list->count - index - 1));
-    items(list)[--list->count] = NOTHINGNESS;
+    writeBarrierSomething(listItem(list, index));
+    listMoveItems(list, index, index + 1, list->count - index - 1);
+    listSetItem(list, --list->count, NOTHINGNESS);
     return true;
 }
 
@@ -99,19 +140,21 @@ Something listGet(List *list, EmojicodeInteger i){
     if (i < 0 || list->count <= i){
         return NOTHINGNESS;
     }
-    return items(list)[i];
+    return listItem(list, i);
 }
 
 Something listSet(EmojicodeInteger index, Something value, Thread *thread) {
-    List *list = stackGetThisObject(thread)->value;
+    List *list = objectValue(stackGetThisObject(thread));
     
     listEnsureCapacity(thread, index + 1);
-    list = stackGetThisObject(thread)->value;
+    list = objectValue(stackGetThisObject(thread));
     
     if (list->count <= index)
         list->count = index + 1;
+    else
+        writeBarrierSomething(listItem(list, index));
     
-    items(list)[index] = value;
+    listSetItem(list, index, value);
     return NOTHINGNESS;
 }
 
@@ -121,16 +164,16 @@ void listShuffleInPlace(List *list) {
     
     for (i = n - 1; i > 0; i--) {
         j = secureRandomNumber(0, i);
-        tmp = items(list)[j];
-        items(list)[j] = items(list)[i];
-        items(list)[i] = tmp;
+        tmp = listItem(list, j);
+        listSetItem(list, j, listItem(list, i));
+        listSetItem(list, i, tmp);
     }
 }
 
 /* MARK: Emoji bridges */
 
 static Something listCountBridge(Thread *thread){
-    return somethingInteger((EmojicodeInteger)((List *)stackGetThisObject(thread)->value)->count);
+    return somethingInteger((EmojicodeInteger)((List *)objectValue(stackGetThisObject(thread)))->count);
 }
 
 static Something listAppendBridge(Thread *thread){
@@ -139,20 +182,20 @@ static Something listAppendBridge(Thread *thread){
 }
 
 static Something listGetBridge(Thread *thread){
-    return listGet(stackGetThisObject(thread)->value, unwrapInteger(stackGetVariable(0, thread)));
+    return listGet(objectValue(stackGetThisObject(thread)), unwrapInteger(stackGetVariable(0, thread)));
 }
 
 static Something listRemoveBridge(Thread *thread){
-    return listRemoveByIndex(stackGetThisObject(thread)->value, unwrapInteger(stackGetVariable(0, thread))) ? EMOJICODE_TRUE : EMOJICODE_FALSE;
+    return listRemoveByIndex(objectValue(stackGetThisObject(thread)), unwrapInteger(stackGetVariable(0, thread))) ? EMOJICODE_TRUE : EMOJICODE_FALSE;
 }
 
 static Something listPopBridge(Thread *thread){
-    return listPop(stackGetThisObject(thread)->value);
+    return listPop(objectValue(stackGetThisObject(thread)));
 }
 
 static Something listInsertBridge(Thread *thread){
     EmojicodeInteger index = unwrapInteger(stackGetVariable(0, thread));
-    List *list = stackGetThisObject(thread)->value;
+    List *list = objectValue(stackGetThisObject(thread));
     
     if (index < 0) {
         index += list->count;
@@ -165,10 +208,10 @@ static Something listInsertBridge(Thread *thread){
         expandListSize(thread);
     }
     
-    list = stackGetThisObject(thread)->value;
+    list = objectValue(stackGetThisObject(thread));
     
-    memmove(items(list) + index + 1, items(list) + index, sizeof(Something) * (list->count++ - index));
-    items(list)[index] = stackGetVariable(1, thread);
+    listMoveItems(list, index + 1, index, list->count++ - index);
+    listSetItem(list, index, stackGetVariable(1, thread));
     
     return NOTHINGNESS;
 }
@@ -177,23 +220,23 @@ static void listQSort(Thread *thread, size_t off, size_t n) {
     if (n < 2)
         return;
     
-    Something *items = items((List *)stackGetThisObject(thread)->value) + off;
-    Something pivot = items[n / 2];
+    List *list = objectValue(stackGetThisObject(thread));
+    Something pivot = listItem(list, off + n / 2);
     size_t i, j;
     
     for (i = 0, j = n - 1; ; i++, j--) {
         while (true) {
-            Something args[2] = {items[i], pivot};
+            Something args[2] = {listItem(list, off + i), pivot};
             EmojicodeInteger c = executeCallableExtern(stackGetVariable(0, thread).object, args, thread).raw;
-            items = items((List *)stackGetThisObject(thread)->value) + off;
+            list = objectValue(stackGetThisObject(thread));
             if (c >= 0) break;
             i++;
         }
         
         while (true) {
-            Something args[2] = {pivot, items[j]};
+            Something args[2] = {pivot, listItem(list, off + j)};
             EmojicodeInteger c = executeCallableExtern(stackGetVariable(0, thread).object, args, thread).raw;
-            items = items((List *)stackGetThisObject(thread)->value) + off;
+            list = objectValue(stackGetThisObject(thread));
             if (c >= 0) break;
             j--;
         }
@@ -201,9 +244,9 @@ static void listQSort(Thread *thread, size_t off, size_t n) {
         if (i >= j)
             break;
         
-        Something temp = items[i];
-        items[i] = items[j];
-        items[j] = temp;
+        Something temp = listItem(list, off + i);
+        listSetItem(list, off + i, listItem(list, off + j));
+        listSetItem(list, off + j, temp);
     }
     
     listQSort(thread, off, i);
@@ -211,7 +254,7 @@ static void listQSort(Thread *thread, size_t off, size_t n) {
 }
 
 static Something listSort(Thread *thread) {
-    List *list = stackGetThisObject(thread)->value;
+    List *list = objectValue(stackGetThisObject(thread));
     listQSort(thread, 0, list->count);
     return NOTHINGNESS;
 }
@@ -221,26 +264,31 @@ static Something listFromListBridge(Thread *thread) {
     stackPush(stackGetThisContext(thread), 1, 0, thread);
     stackSetVariable(0, somethingObject(listO), thread);
     
-    List *list = listO->value;
-    List *cpdList = stackGetThisObject(thread)->value;
+    List *list = objectValue(listO);
+    List *cpdList = objectValue(stackGetThisObject(thread));
     
     list->count = cpdList->count;
     list->capacity = cpdList->capacity;
     
-    Object *items = newArray(sizeof(Something) * cpdList->capacity);
+    Object *items = newListItems(cpdList->capacity);
     listO = stackGetVariable(0, thread).object;
-    list = listO->value;
-    cpdList = stackGetThisObject(thread)->value;
+    list = objectValue(listO);
+    cpdList = objectValue(stackGetThisObject(thread));
     list->items = items;
     
-    memcpy(items(list), items(cpdList), cpdList->count * sizeof(Something));
+    memcpy(values(list), values(cpdList), cpdList->count * sizeof(ListValue));
+    memcpy(types(list), types(cpdList), cpdList->count);
     stackPop(thread);
     return somethingObject(listO);
 }
 
 static Something listRemoveAllBridge(Thread *thread) {
-    List *list = stackGetThisObject(thread)->value;
-    memset(items(list), 0, list->count);
+    List *list = objectValue(stackGetThisObject(thread));
+    for (size_t i = 0; incrementalMarking && i < list->count; i++) {
+        writeBarrierSomething(listItem(list, i));
+    }
+    memset(values(list), 0, list->count * sizeof(ListValue));
+    memset(types(list), 0, list->count);
     list->count = 0;
     return NOTHINGNESS;
 }
@@ -250,7 +298,7 @@ static Something listSetBridge(Thread *thread) {
 }
 
 static Something listShuffleInPlaceBridge(Thread *thread) {
-    listShuffleInPlace(stackGetThisObject(thread)->value);
+    listShuffleInPlace(objectValue(stackGetThisObject(thread)));
     return NOTHINGNESS;
 }
 
@@ -259,6 +307,149 @@ static Something listEnsureCapacityBridge(Thread *thread) {
     return NOTHINGNESS;
 }
 
+/* MARK: Parallel algorithms */
+
+/** Returns a new list of @c count items, which are Nothingness until they are set. */
+static Object* newListWithCount(size_t count, Thread *thread) {
+    Object *listO = newObject(CL_LIST);
+    if (count == 0) {
+        return listO;
+    }
+    stackPush(stackGetThisContext(thread), 1, 0, thread);
+    stackSetVariable(0, somethingObject(listO), thread);
+    Object *items = newListItems(count);
+    listO = stackGetVariable(0, thread).object;
+    stackPop(thread);
+    
+    List *list = objectValue(listO);
+    list->items = items;
+    list->capacity = count;
+    list->count = count;
+    return listO;
+}
+
+typedef struct {
+    size_t count;
+    size_t chunkCount;
+    /** Whether the item passed the test, used by the parallel filter. */
+    bool *passed;
+} ParallelListContext;
+
+/** The index of the first item of @c chunk. The chunk ends where the next chunk begins. */
+#define chunkStart(context, chunk) ((context)->count * (chunk) / (context)->chunkCount)
+
+/** The indices of the objects passed to taskPoolRunChunks. */
+enum {
+    parallelList,
+    parallelCallable,
+    parallelResults
+};
+
+static void listMapChunk(Object **objects, void *contextv, size_t chunk, Thread *thread) {
+    ParallelListContext *context = contextv;
+    for (size_t i = chunkStart(context, chunk), end = chunkStart(context, chunk + 1); i < end; i++) {
+        Something args[1] = {listItem(objectValue(objects[parallelList]), i)};
+        Something result = executeCallableExtern(objects[parallelCallable], args, thread);
+        listSetItem(objectValue(objects[parallelResults]), i, result);
+    }
+}
+
+static void listFilterChunk(Object **objects, void *contextv, size_t chunk, Thread *thread) {
+    ParallelListContext *context = contextv;
+    for (size_t i = chunkStart(context, chunk), end = chunkStart(context, chunk + 1); i < end; i++) {
+        Something args[1] = {listItem(objectValue(objects[parallelList]), i)};
+        context->passed[i] = unwrapBool(executeCallableExtern(objects[parallelCallable], args, thread));
+    }
+}
+
+static void listReduceChunk(Object **objects, void *contextv, size_t chunk, Thread *thread) {
+    ParallelListContext *context = contextv;
+    size_t i = chunkStart(context, chunk), end = chunkStart(context, chunk + 1);
+    Something accumulator = listItem(objectValue(objects[parallelList]), i);
+    for (i++; i < end; i++) {
+        Something args[2] = {accumulator, listItem(objectValue(objects[parallelList]), i)};
+        accumulator = executeCallableExtern(objects[parallelCallable], args, thread);
+    }
+    listSetItem(objectValue(objects[parallelResults]), chunk, accumulator);
+}
+
+static void listForEachChunk(Object **objects, void *contextv, size_t chunk, Thread *thread) {
+    ParallelListContext *context = contextv;
+    for (size_t i = chunkStart(context, chunk), end = chunkStart(context, chunk + 1); i < end; i++) {
+        Something args[1] = {listItem(objectValue(objects[parallelList]), i)};
+        executeCallableExtern(objects[parallelCallable], args, thread);
+    }
+}
+
+static Something listParallelMap(Thread *thread) {
+    size_t count = ((List *)objectValue(stackGetThisObject(thread)))->count;
+    Object *results = newListWithCount(count, thread);
+    
+    Object *pool = stackGetVariable(0, thread).object;
+    ParallelListContext context = {count, taskPoolChunkCount(pool, count), NULL};
+    Object *objects[] = {stackGetThisObject(thread), stackGetVariable(1, thread).object, results};
+    taskPoolRunChunks(pool, context.chunkCount, listMapChunk, objects, 3, &context, thread);
+    return somethingObject(objects[parallelResults]);
+}
+
+static Something listParallelFilter(Thread *thread) {
+    size_t count = ((List *)objectValue(stackGetThisObject(thread)))->count;
+    Object *pool = stackGetVariable(0, thread).object;
+    ParallelListContext context = {count, taskPoolChunkCount(pool, count), calloc(count ? count : 1, sizeof(bool))};
+    if (!context.passed) {
+        error("Could not allocate memory for the filter!");
+    }
+    Object *objects[] = {stackGetThisObject(thread), stackGetVariable(1, thread).object};
+    taskPoolRunChunks(pool, context.chunkCount, listFilterChunk, objects, 2, &context, thread);
+    
+    size_t passedCount = 0;
+    for (size_t i = 0; i < count; i++) {
+        passedCount += context.passed[i];
+    }
+    Object *results = newListWithCount(passedCount, thread);
+    List *list = objectValue(stackGetThisObject(thread));
+    List *resultsList = objectValue(results);
+    for (size_t i = 0, j = 0; i < count; i++) {
+        if (context.passed[i]) {
+            listSetItem(resultsList, j++, listItem(list, i));
+        }
+    }
+    free(context.passed);
+    return somethingObject(results);
+}
+
+static Something listParallelReduce(Thread *thread) {
+    size_t count = ((List *)objectValue(stackGetThisObject(thread)))->count;
+    Object *pool = stackGetVariable(0, thread).object;
+    ParallelListContext context = {count, taskPoolChunkCount(pool, count), NULL};
+    Object *results = newListWithCount(context.chunkCount, thread);
+    
+    Object *objects[] = {stackGetThisObject(thread), stackGetVariable(2, thread).object, results};
+    taskPoolRunChunks(stackGetVariable(0, thread).object, context.chunkCount, listReduceChunk, objects, 3, &context,
+                      thread);
+    
+    //The results of the chunks are combined in order, which makes the result deterministic
+    Something accumulator = stackGetVariable(1, thread);
+    stackPush(stackGetThisContext(thread), 2, 0, thread);
+    stackSetVariable(0, somethingObject(objects[parallelResults]), thread);
+    stackSetVariable(1, somethingObject(objects[parallelCallable]), thread);
+    for (size_t i = 0; i < context.chunkCount; i++) {
+        Something args[2] = {accumulator, listItem(objectValue(stackGetVariable(0, thread).object), i)};
+        accumulator = executeCallableExtern(stackGetVariable(1, thread).object, args, thread);
+    }
+    stackPop(thread);
+    return accumulator;
+}
+
+static Something listParallelForEach(Thread *thread) {
+    size_t count = ((List *)objectValue(stackGetThisObject(thread)))->count;
+    Object *pool = stackGetVariable(0, thread).object;
+    ParallelListContext context = {count, taskPoolChunkCount(pool, count), NULL};
+    Object *objects[] = {stackGetThisObject(thread), stackGetVariable(1, thread).object};
+    taskPoolRunChunks(pool, context.chunkCount, listForEachChunk, objects, 2, &context, thread);
+    return NOTHINGNESS;
+}
+
 static void initListEmptyBridge(Thread *thread) {
     //Nothing to do
     //The Real-Time Engine guarantees pre-nulled objects.
@@ -266,8 +457,8 @@ static void initListEmptyBridge(Thread *thread) {
 
 static void initListWithCapacity(Thread *thread) {
     EmojicodeInteger capacity = stackGetVariable(0, thread).raw;
-    Object *n = newArray(sizeCalculationWithOverflowProtection(capacity, sizeof(Something)));
-    List *list = stackGetThisObject(thread)->value;
+    Object *n = newListItems(capacity);
+    List *list = objectValue(stackGetThisObject(thread));
     list->capacity = capacity;
     list->items = n;
 }
@@ -298,6 +489,14 @@ FunctionFunctionPointer listMethodForName(EmojicodeChar method) {
             return listSetBridge;
         case 0x1f434: //🐴
             return listEnsureCapacityBridge;
+        case 0x1f406: //🐆
+            return listParallelMap;
+        case 0x1f405: //🐅
+            return listParallelFilter;
+        case 0x1f40e: //🐎
+            return listParallelReduce;
+        case 0x1f41d: //🐝
+            return listParallelForEach;
     }
     return NULL;
 }
@@ -6,6 +6,7 @@
 //  Copyright (c) 2015 Theo Weidmann. All rights reserved.
 //
 
+#include "Emojicode.h"
 #include "EmojicodeString.h"
 
 #include <string.h>
@@ -23,7 +24,7 @@ EmojicodeInteger stringCompare(String *a, String *b) {
         return a->length - b->length;
     }
     
-    return memcmp(a->characters->value, b->characters->value, a->length * sizeof(EmojicodeChar));
+    return memcmp(objectValue(a->characters), objectValue(b->characters), a->length * sizeof(EmojicodeChar));
 }
 
 bool stringEqual(String *a, String *b){
@@ -35,7 +36,7 @@ bool stringBeginsWith(String *a, String *with){
         return false;
     }
     
-    return memcmp(a->characters->value, with->characters->value, with->length * sizeof(EmojicodeChar)) == 0;
+    return memcmp(objectValue(a->characters), objectValue(with->characters), with->length * sizeof(EmojicodeChar)) == 0;
 }
 
 bool stringEndsWith(String *a, String *end){
@@ -43,14 +44,14 @@ bool stringEndsWith(String *a, String *end){
         return false;
     }
     
-    return memcmp(((EmojicodeChar*)a->characters->value) + (a->length - end->length), end->characters->value, end->length * sizeof(EmojicodeChar)) == 0;
+    return memcmp(((EmojicodeChar*)objectValue(a->characters)) + (a->length - end->length), objectValue(end->characters), end->length * sizeof(EmojicodeChar)) == 0;
 }
 
 /** @warning GC-invoking */
 Object* stringSubstring(Object *stro, EmojicodeInteger from, EmojicodeInteger length, Thread *thread){
     stackPush(somethingObject(stro), 1, 0, thread);
     {
-        String *string = stackGetThisObject(thread)->value;
+        String *string = objectValue(stackGetThisObject(thread));
         if (from >= string->length){
             length = 0;
             from = 0;
@@ -70,19 +71,19 @@ Object* stringSubstring(Object *stro, EmojicodeInteger from, EmojicodeInteger le
     Object *co = newArray(length * sizeof(EmojicodeChar));
     
     Object *ostro = stackGetVariable(0, thread).object;
-    String *ostr = ostro->value;
+    String *ostr = objectValue(ostro);
     
     ostr->length = length;
     ostr->characters = co;
     
-    memcpy(ostr->characters->value, characters((String *)stackGetThisObject(thread)->value) + from, length * sizeof(EmojicodeChar));
+    memcpy(objectValue(ostr->characters), characters((String *)objectValue(stackGetThisObject(thread))) + from, length * sizeof(EmojicodeChar));
     
     stackPop(thread);
     return ostro;
 }
 
 void initStringFromSymbolList(Object *string, List *list){
-    String *str = string->value;
+    String *str = objectValue(string);
     
     size_t count = list->count;
     str->length = count;
@@ -113,10 +114,15 @@ Object* stringFromChar(const char *cstring){
         return emptyString;
     }
     
-    Object *stro = newObject(CL_STRING);
-    String *string = stro->value;
+    Thread *thread = currentThread;
+    stackPush(somethingObject(newObject(CL_STRING)), 0, 0, thread);
+    Object *chars = newArray(len * sizeof(EmojicodeChar));
+    Object *stro = stackGetThisObject(thread);
+    stackPop(thread);
+    
+    String *string = objectValue(stro);
     string->length = len;
-    string->characters = newArray(len * sizeof(EmojicodeChar));
+    string->characters = chars;
     
     u8_toucs(characters(string), len, cstring, strlen(cstring));
     
@@ -126,7 +132,7 @@ Object* stringFromChar(const char *cstring){
 //MARK: Bridges
 
 static Something stringPrintStdoutBrigde(Thread *thread){
-    String *string = stackGetThisObject(thread)->value;
+    String *string = objectValue(stackGetThisObject(thread));
     char *utf8str = stringToChar(string);
     printf("%s\n", utf8str);
     free(utf8str);
@@ -134,15 +140,15 @@ static Something stringPrintStdoutBrigde(Thread *thread){
 }
 
 static Something stringEqualBridge(Thread *thread){
-    String *a = stackGetThisObject(thread)->value;
-    String *b = stackGetVariable(0, thread).object->value;
+    String *a = objectValue(stackGetThisObject(thread));
+    String *b = objectValue(stackGetVariable(0, thread).object);
     return stringEqual(a, b) ? EMOJICODE_TRUE : EMOJICODE_FALSE;
 }
 
 static Something stringSubstringBridge(Thread *thread){
     EmojicodeInteger from = unwrapInteger(stackGetVariable(0, thread));
     EmojicodeInteger length = unwrapInteger(stackGetVariable(1, thread));
-    String *string = stackGetThisObject(thread)->value;
+    String *string = objectValue(stackGetThisObject(thread));
     
     if (from < 0) {
         from = (EmojicodeInteger)string->length + from;
@@ -155,8 +161,8 @@ static Something stringSubstringBridge(Thread *thread){
 }
 
 static Something stringIndexOf(Thread *thread){
-    String *string = stackGetThisObject(thread)->value;
-    String *search = stackGetVariable(0, thread).object->value;
+    String *string = objectValue(stackGetThisObject(thread));
+    String *search = objectValue(stackGetVariable(0, thread).object);
     
     void *location = findBytesInBytes(characters(string), string->length * sizeof(EmojicodeChar),
                                       characters(search), search->length * sizeof(EmojicodeChar));
@@ -169,7 +175,7 @@ static Something stringIndexOf(Thread *thread){
 }
 
 static Something stringTrimBridge(Thread *thread){
-    String *string = stackGetThisObject(thread)->value;
+    String *string = objectValue(stackGetThisObject(thread));
     
     EmojicodeInteger start = 0;
     EmojicodeInteger stop = string->length - 1;
@@ -184,43 +190,53 @@ static Something stringTrimBridge(Thread *thread){
 }
 
 static void stringGetInput(Thread *thread) {
-    String *prompt = stackGetVariable(0, thread).object->value;
+    String *prompt = objectValue(stackGetVariable(0, thread).object);
     char *utf8str = stringToChar(prompt);
     printf("%s\n", utf8str);
     fflush(stdout);
     free(utf8str);
     
-    int bufferSize = 50, oldBufferSize = 0;
-    Object *buffer = newArray(bufferSize);
-    size_t bufferUsedSize = 0;
+    //The line is read into native memory, as the GC may run while waiting for input
+    size_t bufferSize = 50, bufferUsedSize = 0;
+    char *buffer = malloc(bufferSize);
+    if (!buffer) {
+        error("Could not allocate input buffer!");
+    }
+    buffer[0] = 0;
     
-    while (true) {
-        fgets((char *)buffer->value + oldBufferSize, bufferSize - oldBufferSize, stdin);
-        
-        bufferUsedSize = strlen(buffer->value);
-        
-        if(bufferUsedSize < bufferSize - 1){
-            if (((char *)buffer->value)[bufferUsedSize - 1] == '\n') {
-                bufferUsedSize -= 1;
-            }
+    allowGC();
+    while (fgets(buffer + bufferUsedSize, (int)(bufferSize - bufferUsedSize), stdin) != NULL) {
+        bufferUsedSize += strlen(buffer + bufferUsedSize);
+        if (bufferUsedSize > 0 && buffer[bufferUsedSize - 1] == '\n') {
             break;
         }
-        
-        oldBufferSize = bufferSize - 1;
-        bufferSize *= 2;
-        buffer = resizeArray(buffer, bufferSize);
+        if (bufferSize - bufferUsedSize < 2) {
+            bufferSize *= 2;
+            char *newBuffer = realloc(buffer, bufferSize);
+            if (!newBuffer) {
+                free(buffer);
+                error("Could not allocate input buffer!");
+            }
+            buffer = newBuffer;
+        }
+    }
+    disallowGCAndPauseIfNeeded();
+    
+    if (bufferUsedSize > 0 && buffer[bufferUsedSize - 1] == '\n') {
+        bufferUsedSize -= 1;
     }
 
-    EmojicodeInteger len = u8_strlen_l(buffer->value, bufferUsedSize);
+    EmojicodeInteger len = u8_strlen_l(buffer, bufferUsedSize);
     
-    String *string = stackGetThisObject(thread)->value;
+    String *string = objectValue(stackGetThisObject(thread));
     string->length = len;
     
     Object *chars = newArray(len * sizeof(EmojicodeChar));
-    string = stackGetThisObject(thread)->value;
+    string = objectValue(stackGetThisObject(thread));
     string->characters = chars;
     
-    u8_toucs(characters(string), len, buffer->value, bufferUsedSize);
+    u8_toucs(characters(string), len, buffer, bufferUsedSize);
+    free(buffer);
 }
 
 static Something stringSplitByStringBridge(Thread *thread) {
@@ -232,11 +248,11 @@ static Something stringSplitByStringBridge(Thread *thread) {
     
     EmojicodeInteger firstOfSeperator = 0, seperatorIndex = 0, firstAfterSeperator = 0;
     
-    for (EmojicodeInteger i = 0, l = ((String *)stackGetThisObject(thread)->value)->length; i < l; i++) {
+    for (EmojicodeInteger i = 0, l = ((String *)objectValue(stackGetThisObject(thread)))->length; i < l; i++) {
         Object *stringObject = stackGetThisObject(thread);
         Object *separatorObject = stackGetVariable(0, thread).object;
-        String *separator = (String *)separatorObject->value;
-        if(characters((String *)stringObject->value)[i] == characters(separator)[seperatorIndex]){
+        String *separator = (String *)objectValue(separatorObject);
+        if(characters((String *)objectValue(stringObject))[i] == characters(separator)[seperatorIndex]){
             if (seperatorIndex == 0) {
                 firstOfSeperator = i;
             }
@@ -266,7 +282,7 @@ static Something stringSplitByStringBridge(Thread *thread) {
     }
     
     Object *stringObject = stackGetThisObject(thread);
-    String *string = (String *)stringObject->value;
+    String *string = (String *)objectValue(stringObject);
     listAppend(stackGetVariable(1, thread).object, somethingObject(stringSubstring(stringObject, firstAfterSeperator, string->length - firstAfterSeperator, thread)), thread);
     
     Something list = stackGetVariable(1, thread);
@@ -275,21 +291,21 @@ static Something stringSplitByStringBridge(Thread *thread) {
 }
 
 static Something stringLengthBridge(Thread *thread){
-    String *string = stackGetThisObject(thread)->value;
+    String *string = objectValue(stackGetThisObject(thread));
     return somethingInteger((EmojicodeInteger)string->length);
 }
 
 static Something stringUTF8LengthBridge(Thread *thread){
-    String *str = stackGetThisObject(thread)->value;
-    return somethingInteger((EmojicodeInteger)u8_codingsize(str->characters->value, str->length));
+    String *str = objectValue(stackGetThisObject(thread));
+    return somethingInteger((EmojicodeInteger)u8_codingsize(objectValue(str->characters), str->length));
 }
 
 static Something stringByAppendingSymbolBridge(Thread *thread){ //TODO: GC-Safety
-    Object *co = newArray((((String *)stackGetThisObject(thread)->value)->length + 1) * sizeof(EmojicodeChar));
-    String *string = stackGetThisObject(thread)->value;
+    Object *co = newArray((((String *)objectValue(stackGetThisObject(thread)))->length + 1) * sizeof(EmojicodeChar));
+    String *string = objectValue(stackGetThisObject(thread));
     
     Object *ostro = newObject(CL_STRING);
-    String *ostr = ostro->value;
+    String *ostr = objectValue(ostro);
     
     ostr->length = string->length + 1;
     ostr->characters = co;
@@ -303,7 +319,7 @@ static Something stringByAppendingSymbolBridge(Thread *thread){ //TODO: GC-Safet
 
 static Something stringSymbolAtBridge(Thread *thread){
     EmojicodeInteger index = unwrapInteger(stackGetVariable(0, thread));
-    String *str = stackGetThisObject(thread)->value;
+    String *str = objectValue(stackGetThisObject(thread));
     if(index >= str->length){
         return NOTHINGNESS;
     }
@@ -312,11 +328,11 @@ static Something stringSymbolAtBridge(Thread *thread){
 }
 
 static Something stringBeginsWithBridge(Thread *thread){
-    return stringBeginsWith(stackGetThisObject(thread)->value, stackGetVariable(0, thread).object->value) ? EMOJICODE_TRUE : EMOJICODE_FALSE;
+    return stringBeginsWith(objectValue(stackGetThisObject(thread)), objectValue(stackGetVariable(0, thread).object)) ? EMOJICODE_TRUE : EMOJICODE_FALSE;
 }
 
 static Something stringEndsWithBridge(Thread *thread){
-    return stringEndsWith(stackGetThisObject(thread)->value, stackGetVariable(0, thread).object->value) ? EMOJICODE_TRUE : EMOJICODE_FALSE;
+    return stringEndsWith(objectValue(stackGetThisObject(thread)), objectValue(stackGetVariable(0, thread).object)) ? EMOJICODE_TRUE : EMOJICODE_FALSE;
 }
 
 static Something stringSplitBySymbolBridge(Thread *thread){
@@ -326,9 +342,9 @@ static Something stringSplitBySymbolBridge(Thread *thread){
     
     EmojicodeInteger from = 0;
     
-    for (EmojicodeInteger i = 0, l = ((String *)stackGetThisObject(thread)->value)->length; i < l; i++) {
+    for (EmojicodeInteger i = 0, l = ((String *)objectValue(stackGetThisObject(thread)))->length; i < l; i++) {
         Object *stringObject = stackGetThisObject(thread);
-        if (characters((String *)stringObject->value)[i] == separator) {
+        if (characters((String *)objectValue(stringObject))[i] == separator) {
             listAppend(stackGetVariable(0, thread).object, somethingObject(stringSubstring(stringObject, from, i - from, thread)), thread);
             from = i + 1;
         }
@@ -336,7 +352,7 @@ static Something stringSplitBySymbolBridge(Thread *thread){
     }
 
     Object *stringObject = stackGetThisObject(thread);
-    listAppend(stackGetVariable(0, thread).object, somethingObject(stringSubstring(stringObject, from, ((String *) stringObject->value)->length - from, thread)), thread);
+    listAppend(stackGetVariable(0, thread).object, somethingObject(stringSubstring(stringObject, from, ((String *) objectValue(stringObject))->length - from, thread)), thread);
     
     Something list = stackGetVariable(0, thread);
     stackPop(thread);
@@ -344,22 +360,22 @@ static Something stringSplitBySymbolBridge(Thread *thread){
 }
 
 static Something stringToData(Thread *thread){
-    String *str = stackGetThisObject(thread)->value;
+    String *str = objectValue(stackGetThisObject(thread));
     
     size_t ds = u8_codingsize(characters(str), str->length);
     
     Object *bytesObject = newArray(ds);
     
-    str = stackGetThisObject(thread)->value;
-    u8_toutf8(bytesObject->value, ds, characters(str), str->length);
+    str = objectValue(stackGetThisObject(thread));
+    u8_toutf8(objectValue(bytesObject), ds, characters(str), str->length);
     
     stackPush(somethingObject(bytesObject), 0, 0, thread);
     
     Object *o = newObject(CL_DATA);
-    Data *d = o->value;
+    Data *d = objectValue(o);
     d->length = ds;
     d->bytesObject = stackGetThisObject(thread);
-    d->bytes = d->bytesObject->value;
+    d->bytes = objectValue(d->bytesObject);
     
     stackPop(thread);
     
@@ -367,7 +383,7 @@ static Something stringToData(Thread *thread){
 }
 
 static Something stringToCharacterList(Thread *thread){
-    String *str = stackGetThisObject(thread)->value;
+    String *str = objectValue(stackGetThisObject(thread));
     Object *list = newObject(CL_LIST);
     
     for (size_t i = 0; i < str->length; i++) {
@@ -381,7 +397,7 @@ static Something stringJSON(Thread *thread){
 }
 
 static void stringFromSymbolListBridge(Thread *thread){
-    initStringFromSymbolList(stackGetThisObject(thread), stackGetVariable(0, thread).object->value);
+    initStringFromSymbolList(stackGetThisObject(thread), objectValue(stackGetVariable(0, thread).object));
 }
 
 static void stringFromStringList(Thread *thread) {
@@ -389,11 +405,11 @@ static void stringFromStringList(Thread *thread) {
     size_t appendLocation = 0;
     
     {
-        List *list = stackGetVariable(0, thread).object->value;
-        String *glue = stackGetVariable(1, thread).object->value;
+        List *list = objectValue(stackGetVariable(0, thread).object);
+        String *glue = objectValue(stackGetVariable(1, thread).object);
         
         for (size_t i = 0; i < list->count; i++) {
-            stringSize += ((String *)listGet(list, i).object->value)->length;
+            stringSize += ((String *)objectValue(listGet(list, i).object))->length;
         }
         
         if (list->count > 0){
@@ -404,15 +420,15 @@ static void stringFromStringList(Thread *thread) {
     Object *co = newArray(stringSize * sizeof(EmojicodeChar));
     
     {
-        List *list = stackGetVariable(0, thread).object->value;
-        String *glue = stackGetVariable(1, thread).object->value;
+        List *list = objectValue(stackGetVariable(0, thread).object);
+        String *glue = objectValue(stackGetVariable(1, thread).object);
         
-        String *string = stackGetThisObject(thread)->value;
+        String *string = objectValue(stackGetThisObject(thread));
         string->length = stringSize;
         string->characters = co;
         
         for (size_t i = 0; i < list->count; i++) {
-            String *aString = listGet(list, i).object->value;
+            String *aString = objectValue(listGet(list, i).object);
             memcpy(characters(string) + appendLocation, characters(aString), aString->length * sizeof(EmojicodeChar));
             appendLocation += aString->length;
             if(i + 1 < list->count){
@@ -423,6 +439,23 @@ static void stringFromStringList(Thread *thread) {
     }
 }
 
+EmojicodeInteger integerStringLength(EmojicodeInteger n, EmojicodeInteger base) {
+    EmojicodeInteger d = n < 0 ? 2 : 1;
+    while (n /= base) d++;
+    return d;
+}
+
+void integerWriteString(EmojicodeInteger n, EmojicodeInteger base, EmojicodeInteger length,
+                        EmojicodeChar *characters) {
+    EmojicodeInteger a = llabs(n);
+    characters += length;
+    do
+        *--characters =  "0123456789abcdefghijklmnopqrstuvxyz"[a % base % 35];
+    while (a /= base);
+    
+    if (n < 0) characters[-1] = '-';
+}
+
 static Something charactersToInteger(EmojicodeChar *characters, EmojicodeInteger base, EmojicodeInteger length) {
     if (length == 0) {
         return NOTHINGNESS;
@@ -463,14 +496,14 @@ static Something charactersToInteger(EmojicodeChar *characters, EmojicodeInteger
 
 static Something stringToInteger(Thread *thread) {
     EmojicodeInteger base = stackGetVariable(0, thread).raw;
-    String *string = (String *)stackGetThisObject(thread)->value;
+    String *string = (String *)objectValue(stackGetThisObject(thread));
     
     return charactersToInteger(characters(string), base, string->length);
 }
 
 
 static Something stringToDouble(Thread *thread){
-    String *string = (String *)stackGetThisObject(thread)->value;
+    String *string = (String *)objectValue(stackGetThisObject(thread));
     
     if (string->length == 0) {
         return NOTHINGNESS;
@@ -535,15 +568,15 @@ static Something stringToDouble(Thread *thread){
 
 static Something stringToUppercase(Thread *thread) {
     Object *o = newObject(CL_STRING);
-    size_t length = ((String *)stackGetThisObject(thread)->value)->length;
+    size_t length = ((String *)objectValue(stackGetThisObject(thread)))->length;
     stackPush(somethingObject(o), 0, 0, thread);
     Object *characters = newArray(length * sizeof(EmojicodeChar));
     o = stackGetThisObject(thread);
-    String *news = o->value;
+    String *news = objectValue(o);
     news->characters = characters;
     news->length = length;
     stackPop(thread);
-    String *os = stackGetThisObject(thread)->value;
+    String *os = objectValue(stackGetThisObject(thread));
     for (size_t i = 0; i < length; i++) {
         EmojicodeChar c = characters(os)[i];
         if (c <= 'z') characters(news)[i] = toupper(c);
@@ -554,15 +587,15 @@ static Something stringToUppercase(Thread *thread) {
 
 static Something stringToLowercase(Thread *thread) {
     Object *o = newObject(CL_STRING);
-    size_t length = ((String *)stackGetThisObject(thread)->value)->length;
+    size_t length = ((String *)objectValue(stackGetThisObject(thread)))->length;
     stackPush(somethingObject(o), 0, 0, thread);
     Object *characters = newArray(length * sizeof(EmojicodeChar));
     o = stackGetThisObject(thread);
-    String *news = o->value;
+    String *news = objectValue(o);
     news->characters = characters;
     news->length = length;
     stackPop(thread);
-    String *os = stackGetThisObject(thread)->value;
+    String *os = objectValue(stackGetThisObject(thread));
     for (size_t i = 0; i < length; i++) {
         EmojicodeChar c = characters(os)[i];
         if (c <= 'z') characters(news)[i] = tolower(c);
@@ -572,14 +605,14 @@ static Something stringToLowercase(Thread *thread) {
 }
 
 static Something stringCompareBridge(Thread *thread) {
-    String *a = stackGetThisObject(thread)->value;
-    String *b = stackGetVariable(0, thread).object->value;
+    String *a = objectValue(stackGetThisObject(thread));
+    String *b = objectValue(stackGetVariable(0, thread).object);
     return somethingInteger(stringCompare(a, b));
 }
 
 void stringMark(Object *self){
-    if(((String *)self->value)->characters){
-        mark(&((String *)self->value)->characters);
+    if(((String *)objectValue(self))->characters){
+        mark(&((String *)objectValue(self))->characters);
     }
 }
 
@@ -47,7 +47,7 @@ typedef struct {
 #define jsonMaxDepth 256
 
 Something parseJSON(Thread *thread) {
-    const size_t length = ((String*)stackGetThisObject(thread)->value)->length;
+    const size_t length = ((String*)objectValue(stackGetThisObject(thread)))->length;
     JSONStackFrame stack[jsonMaxDepth];
     JSONStackFrame *stackLimit = stack + jsonMaxDepth - 1;
     JSONStackFrame *stackCurrent = stack;
@@ -64,7 +64,7 @@ Something parseJSON(Thread *thread) {
             errorExit();
         }
         
-        c = characters((String *)stackGetThisObject(thread)->value)[i++];
+        c = characters((String *)objectValue(stackGetThisObject(thread)))[i++];
         
         switch (stackCurrent->state) {
             case JSON_STRING:
@@ -74,7 +74,7 @@ Something parseJSON(Thread *thread) {
                         continue;
                     case '"':
                         stackSetVariable(1, somethingObject(newObject(CL_STRING)), thread);
-                        initStringFromSymbolList(stackGetVariable(1, thread).object, stackGetVariable(0, thread).object->value);
+                        initStringFromSymbolList(stackGetVariable(1, thread).object, objectValue(stackGetVariable(0, thread).object));
                         backValue = stackGetVariable(1, thread);
                         stackPop(thread);
                         popTheStack();
@@ -97,7 +97,7 @@ Something parseJSON(Thread *thread) {
                         appendEscape('r', '\r')
                         appendEscape('t', '\t')
                     case 'u': {
-                        EmojicodeChar *chars = characters((String *)stackGetThisObject(thread)->value);
+                        EmojicodeChar *chars = characters((String *)objectValue(stackGetThisObject(thread)));
                         EmojicodeInteger x = 0, high = 0;
                         while (true) {
                             for (size_t e = i + 4; i < e; i++) {
@@ -6,93 +6,404 @@
 //  Copyright (c) 2015 Theo Weidmann. All rights reserved.
 //
 
-#include "EmojicodeAPI.h"
 #include "Emojicode.h"
 #include <string.h>
 #include <pthread.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <math.h>
+#include <signal.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sched.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+#include "utf8.h"
+
+/** Objects are allocated at addresses aligned to 8 bytes. */
+#define alignedSize(size) (((size) + 7) & ~(size_t)7)
 
 size_t memoryUse = 0;
-bool zeroingNeeded = false;
+/**
+ * The memory of the current heap is known to be zeroed from this offset up to @c gcThreshold. Allocations zero the
+ * memory they need in chunks of @c zeroingChunkSize, which keeps this work out of the GC pause.
+ */
+static size_t zeroedOffset = heapSize / 2;
+#define zeroingChunkSize (256 * 1024)
 
 size_t gcThreshold = heapSize / 2;
 
-int pausingThreadsCount = 0;
-bool pauseThreads = false;
-pthread_mutex_t pausingThreadsCountMutex = PTHREAD_MUTEX_INITIALIZER;
+bool compactingGC = false;
+bool incrementalGC = false;
+bool incrementalMarking = false;
+
 pthread_mutex_t allocationMutex = PTHREAD_MUTEX_INITIALIZER;
-pthread_cond_t pauseThreadsFalsedCondition = PTHREAD_COND_INITIALIZER;
-pthread_cond_t threadsCountCondition = PTHREAD_COND_INITIALIZER;
 
-static void* emojicodeMalloc(size_t size){
+/** Set while a thread wants to collect garbage. Running threads poll it at safepoints. */
+static atomic_bool gcRequested = false;
+/** Incremented after every GC cycle. Threads parked at a safepoint wait for it to change. */
+static _Atomic uint32_t gcEpoch = 0;
+
+#ifdef __linux__
+/** Blocks until @c address is woken up if it still contains @c value. May return spuriously. */
+void futexWait(_Atomic uint32_t *address, uint32_t value){
+    syscall(SYS_futex, (uint32_t *)address, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+}
+
+/** Wakes all threads waiting on @c address. */
+void futexWake(_Atomic uint32_t *address){
+    syscall(SYS_futex, (uint32_t *)address, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+/** Wakes one of the threads waiting on @c address. */
+void futexWakeOne(_Atomic uint32_t *address){
+    syscall(SYS_futex, (uint32_t *)address, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+#else
+void futexWait(_Atomic uint32_t *address, uint32_t value){
+    if (atomic_load(address) == value) {
+        sched_yield();
+    }
+}
+
+void futexWake(_Atomic uint32_t *address){}
+
+void futexWakeOne(_Atomic uint32_t *address){}
+#endif
+
+/** All objects allocated with a class that has a deinitializer which have not been finalized yet. */
+static Object **finalizables = NULL;
+static size_t finalizablesCount = 0;
+static size_t finalizablesCapacity = 0;
+static pthread_mutex_t finalizablesMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Header preceding every object in the large object space. Large objects are allocated with mmap, are never
+ * copied by the GC and are freed by a mark and sweep pass after each collection.
+ */
+typedef struct LargeObject {
+    struct LargeObject *next;
+    struct LargeObject *previous;
+    /** The number of bytes mapped for this large object, including this header. */
+    size_t mappedSize;
+    bool marked;
+    /** How often the object is pinned. Pinned objects are not freed, even if they are not reachable anymore. */
+    _Atomic uint32_t pins;
+} LargeObject;
+
+#define largeObjectHeader(o) ((LargeObject *)((Byte *)(o) - sizeof(LargeObject)))
+#define largeObjectObject(lo) ((Object *)((Byte *)(lo) + sizeof(LargeObject)))
+
+static Byte *heapBase;
+static LargeObject *largeObjects = NULL;
+/** The number of bytes mapped for large objects or allocated outside the heap since the last GC cycle. */
+static size_t largeObjectsAllocatedSinceGC = 0;
+/** The number of bytes currently mapped for large objects. */
+static size_t largeObjectsSize = 0;
+
+/** Protected by @c allocationMutex. */
+static GCStatistics statistics;
+/** The duration of every GC pause in nanoseconds. Protected by @c allocationMutex. */
+static uint64_t *pauses = NULL;
+static size_t pausesCount = 0;
+static size_t pausesCapacity = 0;
+
+/** Records an allocation of @c size bytes. The caller must hold @c allocationMutex. */
+static void recordAllocation(Class *class, size_t size){
+    class->allocations++;
+    statistics.bytesAllocated += size;
+    if (memoryUse + largeObjectsSize > statistics.heapHighWaterMark) {
+        statistics.heapHighWaterMark = memoryUse + largeObjectsSize;
+    }
+    if (allocationSampleInterval) {
+        allocationProfilerRecord(class, size);
+    }
+}
+
+/** The file a heap snapshot is written to during the current GC cycle or @c NULL. */
+static FILE *snapshotFile = NULL;
+/** The object whose references are being marked or @c NULL while marking roots. */
+static Object *markingParent = NULL;
+static volatile sig_atomic_t heapSnapshotRequested = false;
+
+static void snapshotNode(Object *o){
+    char name[5] = {0};
+    if (o->class->name) {
+        u8_wc_toutf8(name, o->class->name);
+    }
+    fprintf(snapshotFile, "N %" PRIxPTR " %zu %s\n", (uintptr_t)o, o->size, o->class->name ? name : "[]");
+}
+
+static void snapshotEdge(Object *to){
+    fprintf(snapshotFile, "E %" PRIxPTR " %" PRIxPTR "\n", (uintptr_t)markingParent, (uintptr_t)to);
+}
+
+static uint64_t monotonicNanoseconds(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/** Records a pause of @c pause nanoseconds. The caller must hold @c allocationMutex. */
+static void recordPause(uint64_t pause){
+    if (pausesCount == pausesCapacity) {
+        pausesCapacity = pausesCapacity ? pausesCapacity * 2 : 64;
+        pauses = realloc(pauses, pausesCapacity * sizeof(uint64_t));
+        if (!pauses) {
+            pthread_mutex_unlock(&allocationMutex);
+            error("Cannot allocate GC statistics!");
+        }
+    }
+    pauses[pausesCount++] = pause;
+    statistics.pauses++;
+    statistics.totalPause += pause;
+    if (pause > statistics.maxPause) {
+        statistics.maxPause = pause;
+    }
+}
+
+/**
+ * Stops all other threads and calls @c work. The caller must hold @c allocationMutex, which is released
+ * while the other threads are paused and acquired again before this function returns.
+ */
+static void stopTheWorld(void (*work)(void)){
+    uint64_t pauseStart = monotonicNanoseconds();
+    //Set while holding allocationMutex, so that a thread that wants to collect as well parks instead
+    atomic_store(&gcRequested, true);
+    pthread_mutex_unlock(&allocationMutex);
+    
+    pthread_mutex_lock(&threadListMutex);
+    for (Thread *thread = lastThread; thread != NULL; thread = thread->threadBefore) {
+        if (thread == currentThread) {
+            continue;
+        }
+        while (atomic_load(&thread->state) == THREAD_RUNNING) {
+            futexWait(&thread->state, THREAD_RUNNING);
+        }
+    }
+    work();
+    pthread_mutex_unlock(&threadListMutex);
+    
+    //No other thread can hold allocationMutex now. Taking it before the threads resume makes sure they cannot use
+    //up the reclaimed memory before the allocation that triggered this pause is served.
+    pthread_mutex_lock(&allocationMutex);
+    atomic_store(&gcRequested, false);
+    atomic_fetch_add(&gcEpoch, 1);
+    futexWake(&gcEpoch);
+    
+    recordPause(monotonicNanoseconds() - pauseStart);
+}
+
+/** Stops all other threads and performs a complete GC cycle. See @c stopTheWorld for the locking. */
+static void collectGarbage(){
+    stopTheWorld(gc);
+}
+
+/** Makes sure the current heap is zeroed up to @c end. The caller must hold @c allocationMutex. */
+static void ensureZeroed(size_t end){
+    if (end > zeroedOffset) {
+        size_t chunkEnd = end - zeroedOffset < zeroingChunkSize ? zeroedOffset + zeroingChunkSize : end;
+        if (chunkEnd > gcThreshold) {
+            chunkEnd = gcThreshold;
+        }
+        memset(currentHeap + zeroedOffset, 0, chunkEnd - zeroedOffset);
+        zeroedOffset = chunkEnd;
+    }
+}
+
+static Byte* incrementalMalloc(size_t size);
+static bool incrementalResizeInPlace(Object *ptr, size_t oldSize, size_t newSize);
+
+static void* emojicodeMalloc(size_t size, Class *class){
     pthread_mutex_lock(&allocationMutex);
     pauseForGC(&allocationMutex);
+    if (incrementalGC) {
+        Byte *block = incrementalMalloc(size);
+        recordAllocation(class, size);
+        pthread_mutex_unlock(&allocationMutex);
+        return block;
+    }
     if (memoryUse + size > gcThreshold) {
+        //The mutex is released before terminating as the exit handlers may need it
         if (size > gcThreshold) {
+            pthread_mutex_unlock(&allocationMutex);
             error("Allocation of %zu bytes is too big. Try to enlarge the heap. (Heap size: %zu)", size, heapSize);
         }
         
-        pauseThreads = true;
-        pthread_mutex_unlock(&allocationMutex);
-        
-        pthread_mutex_lock(&pausingThreadsCountMutex);
-        pausingThreadsCount++;
-
-        while (pausingThreadsCount < threads) pthread_cond_wait(&threadsCountCondition, &pausingThreadsCountMutex);
-        gc();
+        collectGarbage();
         
-        pausingThreadsCount--;
-        pthread_mutex_unlock(&pausingThreadsCountMutex);
-
-        pauseThreads = false;
-        pthread_cond_broadcast(&pauseThreadsFalsedCondition);
-        pthread_mutex_lock(&allocationMutex);
+        if (memoryUse + size > gcThreshold) {
+            pthread_mutex_unlock(&allocationMutex);
+            error("Terminating program due to too high memory pressure.");
+        }
     }
     Byte *block = currentHeap + memoryUse;
     memoryUse += size;
+    ensureZeroed(memoryUse);
+    recordAllocation(class, size);
     pthread_mutex_unlock(&allocationMutex);
     return (void *)block;
 }
 
-static void* emojicodeRealloc(void *ptr, size_t oldSize, size_t newSize){
+/**
+ * Pointers to objects that are needed after an allocation that might trigger a GC cycle. The GC updates them
+ * as the objects may be moved.
+ */
+typedef struct AllocationRoot {
+    Object *object;
+    struct AllocationRoot *next;
+} AllocationRoot;
+
+static AllocationRoot *allocationRoots = NULL;
+
+static void addAllocationRoot(AllocationRoot *root){
+    pthread_mutex_lock(&allocationMutex);
+    root->next = allocationRoots;
+    allocationRoots = root;
+    pthread_mutex_unlock(&allocationMutex);
+}
+
+static void removeAllocationRoot(AllocationRoot *root){
+    pthread_mutex_lock(&allocationMutex);
+    for (AllocationRoot **r = &allocationRoots; *r; r = &(*r)->next) {
+        if (*r == root) {
+            *r = root->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&allocationMutex);
+}
+
+static Object* emojicodeRealloc(Object *ptr, size_t oldSize, size_t newSize){
     pthread_mutex_lock(&allocationMutex);
+    if (incrementalGC && incrementalResizeInPlace(ptr, oldSize, newSize)) {
+        pthread_mutex_unlock(&allocationMutex);
+        return ptr;
+    }
     //Nothing has been allocated since the allocation of ptr
-    if (ptr == currentHeap + memoryUse - oldSize) {
+    if (!incrementalGC && (Byte *)ptr == currentHeap + memoryUse - oldSize && memoryUse - oldSize + newSize <= gcThreshold) {
+        if (newSize < oldSize) {
+            memset((Byte *)ptr + newSize, 0, oldSize - newSize);
+        }
         memoryUse += newSize - oldSize;
+        ensureZeroed(memoryUse);
+        if (newSize > oldSize) {
+            statistics.bytesAllocated += newSize - oldSize;
+        }
         pthread_mutex_unlock(&allocationMutex);
         return ptr;
     }
     pthread_mutex_unlock(&allocationMutex);
     
-    void *block = emojicodeMalloc(newSize);
-    memcpy(block, ptr, oldSize);
+    AllocationRoot root = {ptr, NULL};
+    addAllocationRoot(&root);
+    Object *block = emojicodeMalloc(newSize, CL_ARRAY);
+    removeAllocationRoot(&root);
+    memcpy(block, root.object, oldSize);
     return block;
 }
 
+static void registerFinalizable(Object *object){
+    pthread_mutex_lock(&finalizablesMutex);
+    if (finalizablesCount == finalizablesCapacity) {
+        finalizablesCapacity = finalizablesCapacity ? finalizablesCapacity * 2 : 64;
+        finalizables = realloc(finalizables, finalizablesCapacity * sizeof(Object *));
+        if (!finalizables) {
+            error("Cannot allocate finalizer registry!");
+        }
+    }
+    finalizables[finalizablesCount++] = object;
+    pthread_mutex_unlock(&finalizablesMutex);
+}
+
 static Object* newObjectWithSizeInternal(Class *class, size_t size){
-    size_t fullSize = sizeof(Object) + size;
-    Object *object = emojicodeMalloc(fullSize);
+    size_t fullSize = alignedSize(sizeof(Object) + size);
+    Object *object = emojicodeMalloc(fullSize, class);
     object->size = fullSize;
     object->class = class;
-    object->value = ((Byte *)object) + sizeof(Object) + class->instanceVariableCount * sizeof(Something);
+    
+    if (class->deconstruct) {
+        registerFinalizable(object);
+    }
     
     return object;
 }
 
-Something objectGetVariable(Object *o, uint8_t index){
-    return *(Something *)(((Byte *)o) + sizeof(Object) + sizeof(Something) * index);
+/** The instance variables are stored after the value area. */
+#define instanceVariables(o) ((Byte *)(o) + sizeof(Object) + (o)->class->valueSize)
+
+Something objectGetVariable(Object *o, uint8_t kind, uint32_t offset){
+    Byte *variable = instanceVariables(o) + offset;
+    switch (kind) {
+        case IV_OBJECT:
+            return somethingObject(*(Object **)variable);
+        case IV_INTEGER:
+            return somethingInteger(*(EmojicodeInteger *)variable);
+        case IV_DOUBLE:
+            return somethingDouble(*(double *)variable);
+        case IV_BOOLEAN:
+            return somethingBoolean(*variable);
+        default:
+            return *(Something *)variable;
+    }
+}
+
+void objectSetVariable(Object *o, uint8_t kind, uint32_t offset, Something value){
+    Byte *variable = instanceVariables(o) + offset;
+    switch (kind) {
+        case IV_OBJECT:
+            writeBarrier(*(Object **)variable);
+            *(Object **)variable = value.object;
+            break;
+        case IV_INTEGER:
+            *(EmojicodeInteger *)variable = value.raw;
+            break;
+        case IV_DOUBLE:
+            *(double *)variable = value.doubl;
+            break;
+        case IV_BOOLEAN:
+            *variable = unwrapBool(value);
+            break;
+        default:
+            writeBarrierSomething(*(Something *)variable);
+            *(Something *)variable = value;
+    }
+}
+
+/** Returns the integer stored in the instance variable, which either is unboxed or a @c Something. */
+static EmojicodeInteger* objectIntegerVariable(Object *o, uint8_t kind, uint32_t offset){
+    Byte *variable = instanceVariables(o) + offset;
+    return kind == IV_INTEGER ? (EmojicodeInteger *)variable : &((Something *)variable)->raw;
 }
 
-void objectSetVariable(Object *o, uint8_t index, Something value){
-    Something *v = (Something *)(((Byte *)o) + sizeof(Object) + sizeof(Something) * index);
-    *v = value;
+void objectDecrementVariable(Object *o, uint8_t kind, uint32_t offset){
+    (*objectIntegerVariable(o, kind, offset))--;
 }
 
-void objectDecrementVariable(Object *o, uint8_t index){
-    ((Something *)(((Byte *)o) + sizeof(Object) + sizeof(Something) * index))->raw--;
+void objectIncrementVariable(Object *o, uint8_t kind, uint32_t offset){
+    (*objectIntegerVariable(o, kind, offset))++;
 }
 
-void objectIncrementVariable(Object *o, uint8_t index){
-    ((Something *)(((Byte *)o) + sizeof(Object) + sizeof(Something) * index))->raw++;
+void initializerFailed(Thread *thread){
+    thread->initializerFailed = true;
+}
+
+void discardFailedObject(Object *object){
+    if (!object->class->deconstruct) {
+        return;
+    }
+    pthread_mutex_lock(&finalizablesMutex);
+    //The object was most likely registered last
+    for (size_t i = finalizablesCount; i > 0; i--) {
+        if (finalizables[i - 1] == object) {
+            finalizables[i - 1] = finalizables[--finalizablesCount];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&finalizablesMutex);
 }
 
 Object* newObject(Class *class){
@@ -107,118 +418,924 @@ size_t sizeCalculationWithOverflowProtection(size_t items, size_t itemSize) {
     return r;
 }
 
-Object* newArray(size_t size){
-    size_t fullSize = sizeof(Object) + size;
-    Object *object = emojicodeMalloc(fullSize);
+//MARK: Large object space
+
+static bool isLargeObject(Object *o){
+    return (size_t)((Byte *)o - heapBase) >= heapSize;
+}
+
+static size_t largeObjectMappedSize(size_t fullSize){
+    size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    return (sizeof(LargeObject) + fullSize + pageSize - 1) & ~(pageSize - 1);
+}
+
+static void largeObjectLink(LargeObject *lo){
+    lo->previous = NULL;
+    lo->next = largeObjects;
+    if (largeObjects) {
+        largeObjects->previous = lo;
+    }
+    largeObjects = lo;
+}
+
+static void largeObjectUnlink(LargeObject *lo){
+    if (lo->previous) {
+        lo->previous->next = lo->next;
+    }
+    else {
+        largeObjects = lo->next;
+    }
+    if (lo->next) {
+        lo->next->previous = lo->previous;
+    }
+}
+
+/** Allocates a zeroed object with the given full size (including the Object struct) in the large object space. */
+static Object* largeObjectMalloc(size_t fullSize){
+    size_t mappedSize = largeObjectMappedSize(fullSize);
+    
+    pthread_mutex_lock(&allocationMutex);
+    pauseForGC(&allocationMutex);
+    if (largeObjectsAllocatedSinceGC + mappedSize > heapSize / 2) {
+        collectGarbage();
+    }
+    
+    LargeObject *lo = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (lo == MAP_FAILED) {
+        pthread_mutex_unlock(&allocationMutex);
+        error("Allocation of %zu bytes failed. The system is out of memory.", fullSize);
+    }
+    lo->mappedSize = mappedSize;
+    //Objects allocated while the incremental collector marks are considered reachable
+    lo->marked = incrementalMarking;
+    atomic_init(&lo->pins, 0);
+    largeObjectLink(lo);
+    largeObjectsAllocatedSinceGC += mappedSize;
+    largeObjectsSize += mappedSize;
+    recordAllocation(CL_ARRAY, mappedSize);
+    pthread_mutex_unlock(&allocationMutex);
+    
+    return largeObjectObject(lo);
+}
+
+void registerExternalAllocation(size_t size){
+    pthread_mutex_lock(&allocationMutex);
+    pauseForGC(&allocationMutex);
+    if (largeObjectsAllocatedSinceGC + size > heapSize / 2) {
+        collectGarbage();
+    }
+    largeObjectsAllocatedSinceGC += size;
+    statistics.bytesAllocated += size;
+    pthread_mutex_unlock(&allocationMutex);
+}
+
+/** Resizes a large object in place if possible. The object may be moved by the operating system. */
+static Object* largeObjectRealloc(Object *object, size_t fullSize){
+    size_t mappedSize = largeObjectMappedSize(fullSize);
+    
+    pthread_mutex_lock(&allocationMutex);
+    LargeObject *lo = largeObjectHeader(object);
+    if (mappedSize != lo->mappedSize) {
+        largeObjectUnlink(lo);
+#ifdef __linux__
+        LargeObject *nlo = mremap(lo, lo->mappedSize, mappedSize, MREMAP_MAYMOVE);
+        if (nlo == MAP_FAILED) {
+            pthread_mutex_unlock(&allocationMutex);
+            error("Allocation of %zu bytes failed. The system is out of memory.", fullSize);
+        }
+#else
+        LargeObject *nlo = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (nlo == MAP_FAILED) {
+            pthread_mutex_unlock(&allocationMutex);
+            error("Allocation of %zu bytes failed. The system is out of memory.", fullSize);
+        }
+        memcpy(nlo, lo, lo->mappedSize < mappedSize ? lo->mappedSize : mappedSize);
+        munmap(lo, lo->mappedSize);
+#endif
+        largeObjectsSize = largeObjectsSize - nlo->mappedSize + mappedSize;
+        if (mappedSize > nlo->mappedSize) {
+            largeObjectsAllocatedSinceGC += mappedSize - nlo->mappedSize;
+            statistics.bytesAllocated += mappedSize - nlo->mappedSize;
+        }
+        nlo->mappedSize = mappedSize;
+        largeObjectLink(nlo);
+        lo = nlo;
+    }
+    pthread_mutex_unlock(&allocationMutex);
+    
+    return largeObjectObject(lo);
+}
+
+/** Unmaps all large objects that were not marked during the current GC cycle nor are pinned and resets the marks. */
+static void sweepLargeObjects(){
+    LargeObject *lo = largeObjects;
+    while (lo) {
+        LargeObject *next = lo->next;
+        if (lo->marked || atomic_load(&lo->pins)) {
+            lo->marked = false;
+        }
+        else {
+            largeObjectUnlink(lo);
+            largeObjectsSize -= lo->mappedSize;
+            munmap(lo, lo->mappedSize);
+        }
+        lo = next;
+    }
+    largeObjectsAllocatedSinceGC = 0;
+}
+
+/** Copies @c object into a new large object of @c fullSize bytes. This function may invoke the GC. */
+static Object* largeObjectCopy(Object *object, size_t fullSize){
+    AllocationRoot root = {object, NULL};
+    addAllocationRoot(&root);
+    Object *copy = largeObjectMalloc(fullSize);
+    removeAllocationRoot(&root);
+    memcpy(copy, root.object, root.object->size < fullSize ? root.object->size : fullSize);
+    return copy;
+}
+
+//MARK: Arrays
+
+static void initArrayObject(Object *object, size_t fullSize){
     object->size = fullSize;
     object->class = CL_ARRAY;
-    object->value = ((Byte *)object) + sizeof(Object);
-    
+}
+
+Object* newArray(size_t size){
+    size_t fullSize = alignedSize(sizeof(Object) + size);
+    Object *object = fullSize >= largeObjectThreshold ? largeObjectMalloc(fullSize) : emojicodeMalloc(fullSize, CL_ARRAY);
+    initArrayObject(object, fullSize);
     return object;
 }
 
 Object* resizeArray(Object *array, size_t size){
-    size_t fullSize = sizeof(Object) + size;
-    Object *object = emojicodeRealloc(array, array->size, fullSize);
-    object->size = fullSize;
-    object->value = ((Byte *)object) + sizeof(Object);
+    size_t fullSize = alignedSize(sizeof(Object) + size);
+    Object *object;
+    if (isLargeObject(array)) {
+        if (atomic_load(&largeObjectHeader(array)->pins)) {
+            error("A pinned array cannot be resized.");
+        }
+        object = largeObjectRealloc(array, fullSize);
+    }
+    else if (fullSize >= largeObjectThreshold) {
+        object = largeObjectCopy(array, fullSize);
+    }
+    else {
+        object = emojicodeRealloc(array, array->size, fullSize);
+    }
+    initArrayObject(object, fullSize);
+    return object;
+}
+
+//MARK: Pinning
+
+bool pinArray(Object *array){
+    if (!isLargeObject(array)) {
+        //The heap is never pinned
+        return false;
+    }
+    atomic_fetch_add(&largeObjectHeader(array)->pins, 1);
+    return true;
+}
+
+Object* newPinnedArray(size_t size){
+    size_t fullSize = alignedSize(sizeof(Object) + size);
+    Object *object = largeObjectMalloc(fullSize);
+    initArrayObject(object, fullSize);
+    atomic_store(&largeObjectHeader(object)->pins, 1);
     return object;
 }
 
+void unpinArray(Object *array){
+    if (isLargeObject(array)) {
+        //The count is checked before it is decremented so that it never wraps around
+        _Atomic uint32_t *pins = &largeObjectHeader(array)->pins;
+        uint32_t count = atomic_load(pins);
+        while (count && !atomic_compare_exchange_weak(pins, &count, count - 1));
+        if (count) {
+            return;
+        }
+    }
+    error("Unpinned an array that was not pinned.");
+}
+
+//MARK: Mark-compact collector
+
+/** The heap is divided into blocks of 64 words, each described by one word of @c liveWords. */
+#define blockSize 512
+#define blockIndex(p) ((size_t)((Byte *)(p) - heapBase) / blockSize)
+#define wordInBlock(p) (((size_t)((Byte *)(p) - heapBase) / 8) % 64)
+
+/** One bit for every 8 bytes of the heap, which is set for all words of the objects found to be alive. */
+static uint64_t *liveWords;
+/** The number of live bytes before each block, which is where the block’s first live object is moved to. */
+static size_t *blockOffsets;
+/** Whether the references are being updated to the new locations instead of being marked. */
+static bool updatingReferences = false;
+
+/** Sets the bits of all words in the @c size bytes at @c p. */
+static void setWords(uint64_t *bitmap, Byte *p, size_t size){
+    size_t word = (size_t)(p - heapBase) / 8;
+    size_t end = word + size / 8;
+    while (word < end) {
+        size_t bit = word % 64;
+        size_t count = end - word < 64 - bit ? end - word : 64 - bit;
+        bitmap[word / 64] |= (count == 64 ? ~(uint64_t)0 : (((uint64_t)1 << count) - 1)) << bit;
+        word += count;
+    }
+}
+
+static bool isLive(Object *o){
+    return (liveWords[blockIndex(o)] >> wordInBlock(o)) & 1;
+}
+
+static void setLive(Object *o){
+    setWords(liveWords, (Byte *)o, o->size);
+}
+
+/** Returns the first live object at or after @c p, or @c end if there is none, without touching dead objects. */
+static Byte* nextLiveObject(Byte *p, Byte *end){
+    size_t word = (size_t)(p - heapBase) / 8;
+    size_t endWord = (size_t)(end - heapBase) / 8;
+    while (word < endWord) {
+        uint64_t bits = liveWords[word / 64] >> (word % 64);
+        if (bits) {
+            word += __builtin_ctzll(bits);
+            return word < endWord ? heapBase + 8 * word : end;
+        }
+        word = (word / 64 + 1) * 64;
+    }
+    return end;
+}
+
+/** Returns the address a live object is moved to. Objects keep their order, so only live bytes before count. */
+static Object* compactedAddress(Object *o){
+    size_t block = blockIndex(o);
+    uint64_t before = liveWords[block] & (((uint64_t)1 << wordInBlock(o)) - 1);
+    return (Object *)(heapBase + blockOffsets[block] + 8 * __builtin_popcountll(before));
+}
+
+//MARK: Incremental collector
+
+/*
+ * The incremental collector does not move objects. A cycle starts with a pause in which only the roots are marked.
+ * Their references are then marked in slices, which allocating threads run interleaved with the program, and a
+ * final pause marks what is left, finalizes unreachable objects and frees the large objects.
+ *
+ * Everything that was reachable when the cycle started is marked (snapshot at the beginning). To ensure this,
+ * references that are overwritten or removed from an object while marking are passed to @c writeBarrier, which
+ * records them to be marked by the next slice. The roots need no barrier as they are only scanned in the first pause.
+ * Objects allocated during a cycle are marked when they are allocated.
+ *
+ * Other threads are stopped during slices as class markers walk native structures that are not synchronized.
+ */
+
+/** One bit for every word of the objects marked in the current cycle. @c liveWords holds the last cycle’s marks. */
+static uint64_t *markWords;
+/** Objects that have been marked but whose references have not been marked yet. */
+static Object **grayObjects = NULL;
+static size_t grayObjectsCount = 0;
+static size_t grayObjectsCapacity = 0;
+/** The references recorded by @c writeBarrier. Protected by @c satbMutex. */
+static Object **satbBuffer = NULL;
+static size_t satbBufferCount = 0;
+static size_t satbBufferCapacity = 0;
+static pthread_mutex_t satbMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Objects are allocated by bumping @c allocationCursor through a run of words that were not marked in the last cycle
+ * and that ends at @c allocationLimit. The runs are visited in address order and the cursor only goes back to the
+ * start of the heap when a cycle finishes, so that no object allocated before is overwritten.
+ */
+static Byte *allocationCursor;
+static Byte *allocationLimit;
+/** The end of the highest object ever allocated. There are no marks after it. */
+static Byte *heapTop;
+/** The number of bytes marked in the current cycle, including the objects allocated during the cycle. */
+static size_t markedBytes;
+/** The number of bytes allocated since the last marking slice. */
+static size_t allocatedSinceSlice = 0;
+/** The number of bytes marked in a slice for every byte allocated since the slice before. */
+static double markingRate;
+/** A cycle is started when @c memoryUse exceeds this. */
+static size_t markingTrigger = heapSize / 2;
+#define markingSliceInterval (128 * 1024)
+
+static void pushObject(Object ***objects, size_t *count, size_t *capacity, Object *o){
+    if (*count == *capacity) {
+        *capacity = *capacity ? *capacity * 2 : 1024;
+        *objects = realloc(*objects, *capacity * sizeof(Object *));
+        if (!*objects) {
+            error("Cannot allocate GC mark stack!");
+        }
+    }
+    (*objects)[(*count)++] = o;
+}
+
+static bool isMarked(Object *o){
+    return (markWords[blockIndex(o)] >> wordInBlock(o)) & 1;
+}
+
+void writeBarrier(Object *overwritten){
+    if (!incrementalMarking || !overwritten) {
+        return;
+    }
+    pthread_mutex_lock(&satbMutex);
+    pushObject(&satbBuffer, &satbBufferCount, &satbBufferCapacity, overwritten);
+    pthread_mutex_unlock(&satbMutex);
+}
+
+void writeBarrierSomething(Something overwritten){
+    if (incrementalMarking && isRealObject(overwritten)) {
+        writeBarrier(overwritten.object);
+    }
+}
+
 void allocateHeap(){
-    currentHeap = calloc(heapSize, 1);
+    heapBase = currentHeap = calloc(heapSize, 1);
     if (!currentHeap) {
         error("Cannot allocate heap!");
     }
-    otherHeap = currentHeap + (heapSize / 2);
+    if (compactingGC || incrementalGC) {
+        size_t blocks = (heapSize + blockSize - 1) / blockSize;
+        liveWords = calloc(blocks, sizeof(uint64_t));
+        if (incrementalGC) {
+            markWords = calloc(blocks, sizeof(uint64_t));
+        }
+        else {
+            blockOffsets = malloc(blocks * sizeof(size_t));
+        }
+        if (!liveWords || (incrementalGC ? !markWords : !blockOffsets)) {
+            error("Cannot allocate heap!");
+        }
+        allocationCursor = allocationLimit = heapTop = heapBase;
+        gcThreshold = heapSize;
+        zeroedOffset = heapSize;
+        otherHeap = NULL;
+    }
+    else {
+        otherHeap = currentHeap + (heapSize / 2);
+    }
+}
+
+/**
+ * Whether @c o, which lives in the old semispace, was copied during the current GC cycle. The class word of a
+ * copied object holds its new location with the lowest bit set.
+ */
+static bool hasBeenCopied(Object *o){
+    return (uintptr_t)o->class & 1;
+}
+
+static Object* forwardingAddress(Object *o){
+    return (Object *)((uintptr_t)o->class & ~(uintptr_t)1);
+}
+
+/** Marks the instance variables of @c o and calls the class’s marker. */
+static void markReferences(Object *o){
+    Object *parent = markingParent;
+    markingParent = o;
+    
+    Byte *variables = instanceVariables(o);
+    for (uint32_t i = 0; i < o->class->somethingVariableCount; i++) {
+        Something *variable = (Something *)(variables + o->class->somethingVariables[i]);
+        if (isRealObject(*variable)) {
+            mark(&variable->object);
+        }
+    }
+    for (uint32_t i = 0; i < o->class->objectVariableCount; i++) {
+        Object **variable = (Object **)(variables + o->class->objectVariables[i]);
+        if (*variable) {
+            mark(variable);
+        }
+    }
+    
+    //This class can lead the GC to other objects.
+    if (o->class->mark) {
+        o->class->mark(o);
+    }
+    
+    markingParent = parent;
 }
 
 void mark(Object **oPointer){
     Object *o = *oPointer;
-    if (currentHeap <= (Byte *)o->newLocation && (Byte *)o->newLocation < currentHeap + heapSize / 2) {
-        *oPointer = o->newLocation;
+    if (isLargeObject(o)) {
+        //Large objects are never moved, their references are updated separately
+        if (updatingReferences) return;
+        if (snapshotFile) snapshotEdge(o);
+        LargeObject *lo = largeObjectHeader(o);
+        if (!lo->marked) {
+            lo->marked = true;
+            if (snapshotFile) snapshotNode(o);
+            if (incrementalGC) {
+                pushObject(&grayObjects, &grayObjectsCount, &grayObjectsCapacity, o);
+            }
+            else {
+                markReferences(o);
+            }
+        }
+        return;
+    }
+    
+    if (incrementalGC) {
+        if (snapshotFile) snapshotEdge(o);
+        if (!isMarked(o)) {
+            setWords(markWords, (Byte *)o, o->size);
+            markedBytes += o->size;
+            if (snapshotFile) snapshotNode(o);
+            pushObject(&grayObjects, &grayObjectsCount, &grayObjectsCapacity, o);
+        }
+        return;
+    }
+    
+    if (compactingGC) {
+        if (updatingReferences) {
+            *oPointer = compactedAddress(o);
+            return;
+        }
+        if (snapshotFile) snapshotEdge(o);
+        if (!isLive(o)) {
+            setLive(o);
+            if (snapshotFile) snapshotNode(o);
+            markReferences(o);
+        }
+        return;
+    }
+    
+    if (hasBeenCopied(o)) {
+        *oPointer = forwardingAddress(o);
+        if (snapshotFile) snapshotEdge(*oPointer);
         return;
     }
     
-    o->newLocation = (Object *)(currentHeap + memoryUse);
+    Object *newLocation = (Object *)(currentHeap + memoryUse);
     memoryUse += o->size;
     
-    memcpy(o->newLocation, o, o->size);
-    *oPointer = o->newLocation;
+    memcpy(newLocation, o, o->size);
+    o->class = (Class *)((uintptr_t)newLocation | 1);
+    *oPointer = newLocation;
     
-    o->newLocation->value = ((Byte *)o->newLocation) + sizeof(Object) + o->class->instanceVariableCount * sizeof(Something);
+    if (snapshotFile) {
+        snapshotEdge(newLocation);
+        snapshotNode(newLocation);
+    }
+    markReferences(newLocation);
+}
+
+/**
+ * Calls the deinitializers of all registered objects that were not copied and updates the registry
+ * to the new locations of the surviving objects. This only visits objects that need finalization instead
+ * of the whole old semispace.
+ */
+static void finalizeUnreachableObjects(){
+    size_t survivors = 0;
+    for (size_t i = 0; i < finalizablesCount; i++) {
+        Object *o = finalizables[i];
+        if (hasBeenCopied(o)) {
+            finalizables[survivors++] = forwardingAddress(o);
+        }
+        else {
+            o->class->deconstruct(objectValue(o));
+        }
+    }
+    finalizablesCount = survivors;
+}
+
+static void markRoots(){
+    for (Thread *thread = lastThread; thread != NULL; thread = thread->threadBefore) {
+        stackMark(thread);
+    }
     
-    //This class can lead the GC to other objects.
-    if (o->class->mark) {
-        o->class->mark(o->newLocation);
+    for (uint_fast16_t i = 0; i < stringPoolCount; i++) {
+        mark(stringPool + i);
+    }
+    
+    for (AllocationRoot *root = allocationRoots; root != NULL; root = root->next) {
+        mark(&root->object);
     }
+    
+    taskPoolsMark();
+}
+
+/**
+ * Slides all live objects to the start of the heap, keeping their order. References are updated only after all
+ * objects have been moved, so that class markers, which follow references they have just updated, read the
+ * objects at their new locations.
+ */
+static void compactHeap(){
+    size_t blocks = (memoryUse + blockSize - 1) / blockSize;
+    memset(liveWords, 0, blocks * sizeof(uint64_t));
+    markRoots();
+    
+    size_t liveBytes = 0;
+    for (size_t i = 0; i < blocks; i++) {
+        blockOffsets[i] = liveBytes;
+        liveBytes += 8 * __builtin_popcountll(liveWords[i]);
+    }
+    
+    //The objects must be finalized before they are overwritten
+    size_t survivors = 0;
+    for (size_t i = 0; i < finalizablesCount; i++) {
+        Object *o = finalizables[i];
+        if (isLive(o)) {
+            finalizables[survivors++] = compactedAddress(o);
+        }
+        else {
+            o->class->deconstruct(objectValue(o));
+        }
+    }
+    finalizablesCount = survivors;
+    
+    Byte *end = heapBase + memoryUse;
+    for (Byte *p = nextLiveObject(heapBase, end); p < end;) {
+        Object *o = (Object *)p;
+        size_t size = o->size;
+        Object *destination = compactedAddress(o);
+        if (destination != o) {
+            memmove(destination, o, size);
+            statistics.bytesCopied += size;
+        }
+        p = nextLiveObject(p + size, end);
+    }
+    
+    size_t oldMemoryUse = memoryUse;
+    memoryUse = liveBytes;
+    
+    updatingReferences = true;
+    markRoots();
+    for (Byte *p = heapBase; p < heapBase + memoryUse; p += ((Object *)p)->size) {
+        markReferences((Object *)p);
+    }
+    for (LargeObject *lo = largeObjects; lo != NULL; lo = lo->next) {
+        if (lo->marked) {
+            markReferences(largeObjectObject(lo));
+        }
+    }
+    updatingReferences = false;
+    
+    //The space the objects were moved out of is zeroed by the allocations that need it
+    if (oldMemoryUse > memoryUse) {
+        zeroedOffset = memoryUse;
+    }
+}
+
+/** Moves the allocation cursor to the next run of words not marked in the last cycle. Returns false at the heap end. */
+static bool nextFreeRun(){
+    size_t word = (size_t)(allocationLimit - heapBase) / 8;
+    size_t end = heapSize / 8;
+    while (word < end) {
+        uint64_t bits = ~liveWords[word / 64] >> (word % 64);
+        if (bits) {
+            word += __builtin_ctzll(bits);
+            break;
+        }
+        word = (word / 64 + 1) * 64;
+    }
+    if (word >= end) {
+        return false;
+    }
+    allocationCursor = heapBase + 8 * word;
+    while (word < end) {
+        uint64_t bits = liveWords[word / 64] >> (word % 64);
+        if (bits) {
+            word += __builtin_ctzll(bits);
+            break;
+        }
+        word = (word / 64 + 1) * 64;
+    }
+    allocationLimit = heapBase + 8 * (word < end ? word : end);
+    return true;
+}
+
+static Byte* bumpAllocate(size_t size){
+    while ((size_t)(allocationLimit - allocationCursor) < size) {
+        if (!nextFreeRun()) {
+            return NULL;
+        }
+    }
+    Byte *block = allocationCursor;
+    allocationCursor += size;
+    if (allocationCursor > heapTop) {
+        heapTop = allocationCursor;
+    }
+    return block;
+}
+
+/** Marks the references of gray objects until @c budget bytes have been scanned. Returns whether all are marked. */
+static bool markGrayObjects(size_t budget){
+    //All other threads are stopped, so that the buffer can be read without satbMutex
+    while (satbBufferCount) {
+        Object *o = satbBuffer[--satbBufferCount];
+        mark(&o);
+    }
+    size_t scanned = 0;
+    while (grayObjectsCount && scanned < budget) {
+        Object *o = grayObjects[--grayObjectsCount];
+        markReferences(o);
+        scanned += o->size;
+    }
+    return grayObjectsCount == 0;
+}
+
+/** The first pause of an incremental cycle. */
+static void startMarking(){
+    memset(markWords, 0, ((size_t)(heapTop - heapBase) + blockSize - 1) / blockSize * sizeof(uint64_t));
+    markedBytes = 0;
+    satbBufferCount = 0;
+    incrementalMarking = true;
+    markRoots();
+    
+    //Marking should be done before half of the free memory is used up, assuming that most objects are still alive
+    size_t free = heapSize - memoryUse;
+    markingRate = 1 + 2.0 * memoryUse / (free ? free : 1);
+    allocatedSinceSlice = 0;
+}
+
+/** The final pause of an incremental cycle. */
+static void finishMarking(){
+    markGrayObjects(SIZE_MAX);
+    incrementalMarking = false;
+    
+    size_t survivors = 0;
+    for (size_t i = 0; i < finalizablesCount; i++) {
+        Object *o = finalizables[i];
+        if (isMarked(o)) {
+            finalizables[survivors++] = o;
+        }
+        else {
+            o->class->deconstruct(objectValue(o));
+        }
+    }
+    finalizablesCount = survivors;
+    sweepLargeObjects();
+    
+    uint64_t *marks = liveWords;
+    liveWords = markWords;
+    markWords = marks;
+    allocationCursor = allocationLimit = heapBase;
+    memoryUse = markedBytes;
+    markingTrigger = memoryUse + (heapSize - memoryUse) / 2;
+    statistics.collections++;
+}
+
+static void markingSlice(){
+    size_t budget = (size_t)(allocatedSinceSlice * markingRate);
+    allocatedSinceSlice = 0;
+    if (markGrayObjects(budget)) {
+        finishMarking();
+    }
+}
+
+/** Finishes the current cycle, if any, and runs a complete cycle within the same pause. */
+static void collectIncrementally(){
+    if (incrementalMarking) {
+        //A heap snapshot must only contain what the complete cycle reaches
+        FILE *file = snapshotFile;
+        snapshotFile = NULL;
+        finishMarking();
+        snapshotFile = file;
+    }
+    startMarking();
+    finishMarking();
+}
+
+/** Allocates @c size zeroed bytes and runs the incremental collector. The caller must hold @c allocationMutex. */
+static Byte* incrementalMalloc(size_t size){
+    if (size > heapSize) {
+        pthread_mutex_unlock(&allocationMutex);
+        error("Allocation of %zu bytes is too big. Try to enlarge the heap. (Heap size: %zu)", size, heapSize);
+    }
+    if (incrementalMarking) {
+        allocatedSinceSlice += size;
+        if (allocatedSinceSlice >= markingSliceInterval) {
+            stopTheWorld(markingSlice);
+        }
+    }
+    else if (memoryUse + size > markingTrigger) {
+        stopTheWorld(startMarking);
+    }
+    
+    Byte *block = bumpAllocate(size);
+    if (!block && incrementalMarking) {
+        stopTheWorld(finishMarking);
+        block = bumpAllocate(size);
+    }
+    if (!block) {
+        stopTheWorld(collectIncrementally);
+        block = bumpAllocate(size);
+        if (!block) {
+            pthread_mutex_unlock(&allocationMutex);
+            error("Terminating program due to too high memory pressure.");
+        }
+    }
+    memset(block, 0, size);
+    memoryUse += size;
+    if (incrementalMarking) {
+        setWords(markWords, block, size);
+        markedBytes += size;
+    }
+    return block;
+}
+
+/** Resizes @c ptr in place if it is the last object allocated. The caller must hold @c allocationMutex. */
+static bool incrementalResizeInPlace(Object *ptr, size_t oldSize, size_t newSize){
+    if ((Byte *)ptr + oldSize != allocationCursor || (size_t)(allocationLimit - (Byte *)ptr) < newSize) {
+        return false;
+    }
+    if (newSize > oldSize) {
+        memset(allocationCursor, 0, newSize - oldSize);
+        if (incrementalMarking) {
+            setWords(markWords, allocationCursor, newSize - oldSize);
+            markedBytes += newSize - oldSize;
+        }
+        statistics.bytesAllocated += newSize - oldSize;
+    }
+    allocationCursor = (Byte *)ptr + newSize;
+    if (allocationCursor > heapTop) {
+        heapTop = allocationCursor;
+    }
+    memoryUse += newSize - oldSize;
+    return true;
 }
 
 void gc(){
-    if (zeroingNeeded) {
-        memset(otherHeap, 0, heapSize / 2);
+    if (incrementalGC) {
+        collectIncrementally();
+        return;
     }
-    else {
-        zeroingNeeded = true;
+    statistics.collections++;
+    if (compactingGC) {
+        compactHeap();
+        sweepLargeObjects();
+        return;
     }
     
     void *tempHeap = currentHeap;
     currentHeap = otherHeap;
     otherHeap = tempHeap;
-    size_t oldMemoryUse = memoryUse;
     memoryUse = 0;
     
-    for (Thread *thread = lastThread; thread != NULL; thread = thread->threadBefore) {
-        stackMark(thread);
-    }
+    markRoots();
     
-    for (uint_fast16_t i = 0; i < stringPoolCount; i++) {
-        mark(stringPool + i);
+    statistics.bytesCopied += memoryUse;
+    //The copies were written completely, the rest of the semispace still holds the objects of an earlier cycle
+    zeroedOffset = memoryUse;
+    
+    finalizeUnreachableObjects();
+    sweepLargeObjects();
+}
+
+GCStatistics gcStatistics(){
+    pthread_mutex_lock(&allocationMutex);
+    GCStatistics s = statistics;
+    s.largeObjectSpaceSize = largeObjectsSize;
+    pthread_mutex_unlock(&allocationMutex);
+    return s;
+}
+
+static int compareDurations(const void *a, const void *b){
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+uint64_t gcPausePercentile(double percentile){
+    pthread_mutex_lock(&allocationMutex);
+    size_t count = pausesCount;
+    uint64_t *sorted = count ? malloc(count * sizeof(uint64_t)) : NULL;
+    if (sorted) {
+        memcpy(sorted, pauses, count * sizeof(uint64_t));
     }
+    pthread_mutex_unlock(&allocationMutex);
     
-    //Call the deinitializers
-    Byte *currentObjectPointer = otherHeap;
-    while (currentObjectPointer < otherHeap + oldMemoryUse) {
-        Object *currentObject = (Object *)currentObjectPointer;
-        if (!currentObject->newLocation && currentObject->class->deconstruct) {
-            currentObject->class->deconstruct(currentObject->value);
+    if (!sorted) {
+        return 0;
+    }
+    qsort(sorted, count, sizeof(uint64_t), compareDurations);
+    //Nearest rank
+    double rank = percentile / 100 * count;
+    size_t index = rank <= 1 ? 0 : (size_t)ceil(rank) - 1;
+    uint64_t pause = sorted[index < count ? index : count - 1];
+    free(sorted);
+    return pause;
+}
+
+void printGCStatistics(){
+    GCStatistics s = gcStatistics();
+    fprintf(stderr, "GC statistics:\n");
+    fprintf(stderr, "  Collections: %llu\n", (unsigned long long)s.collections);
+    fprintf(stderr, "  Pauses: %llu\n", (unsigned long long)s.pauses);
+    fprintf(stderr, "  Total pause: %.3f ms\n", s.totalPause / 1e6);
+    fprintf(stderr, "  Max pause: %.3f ms\n", s.maxPause / 1e6);
+    fprintf(stderr, "  Pause p50/p90/p99: %.3f/%.3f/%.3f ms\n", gcPausePercentile(50) / 1e6,
+            gcPausePercentile(90) / 1e6, gcPausePercentile(99) / 1e6);
+    fprintf(stderr, "  Bytes allocated: %llu\n", (unsigned long long)s.bytesAllocated);
+    fprintf(stderr, "  Bytes copied: %llu\n", (unsigned long long)s.bytesCopied);
+    fprintf(stderr, "  Heap high-water mark: %llu\n", (unsigned long long)s.heapHighWaterMark);
+    fprintf(stderr, "  Large object space: %llu\n", (unsigned long long)s.largeObjectSpaceSize);
+    fprintf(stderr, "Allocations per class:\n");
+    fprintf(stderr, "  (arrays) %llu\n", (unsigned long long)CL_ARRAY->allocations);
+    for (uint_fast16_t i = 0; i < classCount; i++) {
+        if (classTable[i]->allocations) {
+            char name[5] = {0};
+            u8_wc_toutf8(name, classTable[i]->name);
+            fprintf(stderr, "  %s %llu\n", name, (unsigned long long)classTable[i]->allocations);
         }
-        currentObjectPointer += currentObject->size;
     }
-   
-    if (oldMemoryUse == memoryUse) {
-        error("Terminating program due to too high memory pressure.");
+}
+
+void collectGarbageNow(){
+    pthread_mutex_lock(&allocationMutex);
+    pauseForGC(&allocationMutex);
+    collectGarbage();
+    pthread_mutex_unlock(&allocationMutex);
+}
+
+bool heapSnapshot(const char *path){
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        return false;
     }
+    
+    pthread_mutex_lock(&allocationMutex);
+    pauseForGC(&allocationMutex);
+    fprintf(f, "emojicode-heap-snapshot 1\n");
+    snapshotFile = f;
+    collectGarbage();
+    snapshotFile = NULL;
+    pthread_mutex_unlock(&allocationMutex);
+    
+    fclose(f);
+    return true;
+}
+
+static void heapSnapshotSignalHandler(int signal){
+    heapSnapshotRequested = true;
+}
+
+void installHeapSnapshotSignalHandler(){
+    signal(SIGUSR1, heapSnapshotSignalHandler);
+}
+
+/** Writes the heap snapshot requested with @c SIGUSR1 to the current directory. */
+static void writeRequestedHeapSnapshot(){
+    static int snapshotCount = 0;
+    heapSnapshotRequested = false;
+    
+    char path[64];
+    snprintf(path, sizeof(path), "emojicode-%d-%d.heapsnapshot", (int)getpid(), ++snapshotCount);
+    if (heapSnapshot(path)) {
+        fprintf(stderr, "Heap snapshot written to %s\n", path);
+    }
+    else {
+        fprintf(stderr, "Could not write heap snapshot to %s\n", path);
+    }
+}
+
+/**
+ * Marks @c thread safe, wakes the collecting thread that may be waiting for it and blocks until no GC cycle is
+ * requested anymore.
+ *
+ * A thread stores its state before it loads @c gcRequested, while a collecting thread stores @c gcRequested before
+ * it loads the states. As all of these are sequentially consistent, at least one of them sees the other’s store and
+ * a thread never runs while the GC does.
+ */
+static void parkAtSafepoint(Thread *thread){
+    do {
+        atomic_store(&thread->state, THREAD_SAFE);
+        futexWake(&thread->state);
+        uint32_t epoch;
+        while (epoch = atomic_load(&gcEpoch), atomic_load(&gcRequested)) {
+            futexWait(&gcEpoch, epoch);
+        }
+        atomic_store(&thread->state, THREAD_RUNNING);
+    } while (atomic_load(&gcRequested));
 }
 
 void pauseForGC(pthread_mutex_t *mutex) {
-    if (pauseThreads) {
+    if (heapSnapshotRequested && !mutex) {
+        writeRequestedHeapSnapshot();
+    }
+    //A stale value only delays the thread until its next safepoint. Another cycle may have been requested by the
+    //time the mutex is acquired again.
+    while (atomic_load_explicit(&gcRequested, memory_order_relaxed)) {
         if (mutex) pthread_mutex_unlock(mutex);
-        
-        pthread_mutex_lock(&pausingThreadsCountMutex);
-        pausingThreadsCount++;
-        pthread_cond_signal(&threadsCountCondition);
-        while (pauseThreads) pthread_cond_wait(&pauseThreadsFalsedCondition, &pausingThreadsCountMutex);
-        pausingThreadsCount--;
-        pthread_mutex_unlock(&pausingThreadsCountMutex);
-        
+        parkAtSafepoint(currentThread);
         if (mutex) pthread_mutex_lock(mutex);
     }
 }
 
 void allowGC() {
-    pthread_mutex_lock(&pausingThreadsCountMutex);
-    pausingThreadsCount++;
-    pthread_cond_signal(&threadsCountCondition);
-    pthread_mutex_unlock(&pausingThreadsCountMutex);
+    atomic_store(&currentThread->state, THREAD_SAFE);
+    if (atomic_load(&gcRequested)) {
+        futexWake(&currentThread->state);
+    }
 }
 
 void disallowGCAndPauseIfNeeded() {
-    pthread_mutex_lock(&pausingThreadsCountMutex);
-    while (pauseThreads) pthread_cond_wait(&pauseThreadsFalsedCondition, &pausingThreadsCountMutex);
-    pausingThreadsCount--;
-    pthread_cond_signal(&threadsCountCondition);
-    pthread_mutex_unlock(&pausingThreadsCountMutex);
+    atomic_store(&currentThread->state, THREAD_RUNNING);
+    if (atomic_load(&gcRequested)) {
+        parkAtSafepoint(currentThread);
+    }
 }
 
 bool instanceof(Object *object, Class *class){
@@ -226,5 +1343,5 @@ bool instanceof(Object *object, Class *class){
 }
 
 bool isPossibleObjectPointer(void *s){
-    return (Byte *)s < currentHeap + heapSize/2 && s >= (void *)currentHeap;
+    return (Byte *)s < currentHeap + gcThreshold && s >= (void *)currentHeap;
 }
\ No newline at end of file
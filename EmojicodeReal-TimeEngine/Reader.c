@@ -65,7 +65,7 @@ void readQualifiedTypeName(EmojicodeChar *name, EmojicodeChar *namespace, FILE *
     *namespace = readEmojicodeChar(in);
 }
 
-uint32_t readBlock(EmojicodeCoin **destination, uint8_t *variableCount, FILE *in){
+uint32_t readBlock(EmojicodeCoin **destination, uint8_t *variableCount, EmojicodeCoin **stackMap, FILE *in){
     *variableCount = fgetc(in);
     uint32_t coinCount = readEmojicodeChar(in);
 
@@ -74,6 +74,13 @@ uint32_t readBlock(EmojicodeCoin **destination, uint8_t *variableCount, FILE *in
         (*destination)[i] = readCoin(in);
     }
     
+    EmojicodeCoin referenceCount = readCoin(in);
+    *stackMap = malloc(sizeof(EmojicodeCoin) * (referenceCount + 1));
+    (*stackMap)[0] = referenceCount;
+    for (EmojicodeCoin i = 1; i <= referenceCount; i++) {
+        (*stackMap)[i] = readCoin(in);
+    }
+    
     return coinCount;
 }
 
@@ -90,7 +97,9 @@ void readInitializer(InitializerFunction **table, EmojicodeChar className, FILE
     }
     else {
         initializer->native = false;
-        initializer->tokenCount = readBlock(&initializer->tokenStream, &initializer->variableCount, in);
+        initializer->tokenCount = readBlock(&initializer->tokenStream, &initializer->variableCount,
+                                             &initializer->stackMap, in);
+        allocationProfilerRegisterBlock(initializer->tokenStream, initializer->tokenCount, className, name, true);
     }
     table[vti] = initializer;
 }
@@ -109,7 +118,8 @@ void readFunction(Function **table, EmojicodeChar className, FILE *in, FunctionF
     }
     else {
         method->native = false;
-        method->tokenCount = readBlock(&method->tokenStream, &method->variableCount, in);
+        method->tokenCount = readBlock(&method->tokenStream, &method->variableCount, &method->stackMap, in);
+        allocationProfilerRegisterBlock(method->tokenStream, method->tokenCount, className, methodName, false);
     }
     table[vti] = method;
 }
@@ -123,6 +133,20 @@ void readProtocolAgreement(Function **vmt, Function ***pmt, uint_fast16_t offset
     }
 }
 
+/** Reads the offsets of a class’s own instance variables of one storage kind and appends them to @c superOffsets. */
+void readInstanceVariableOffsets(uint32_t **offsets, uint32_t *count, uint32_t *superOffsets, uint32_t superCount,
+                                 FILE *in){
+    uint_fast16_t ownCount = readUInt16(in);
+    *count = superCount + ownCount;
+    *offsets = malloc(sizeof(uint32_t) * *count);
+    if (superCount) {
+        memcpy(*offsets, superOffsets, sizeof(uint32_t) * superCount);
+    }
+    for (uint_fast16_t i = 0; i < ownCount; i++) {
+        (*offsets)[superCount + i] = readEmojicodeChar(in);
+    }
+}
+
 void readPackage(FILE *in){
     static uint16_t classNextIndex = 0;
     
@@ -169,8 +193,20 @@ void readPackage(FILE *in){
         Class *class = malloc(sizeof(Class));
         classTable[classNextIndex++] = class;
         
-        class->superclass = classTable[readUInt16(in)];
-        class->instanceVariableCount = readUInt16(in);
+        class->name = name;
+        class->allocations = 0;
+        
+        //A class without superclass has its own index written
+        Class *superclass = classTable[readUInt16(in)];
+        class->superclass = superclass != class ? superclass : NULL;
+        
+        class->instanceVariablesSize = readEmojicodeChar(in);
+        readInstanceVariableOffsets(&class->somethingVariables, &class->somethingVariableCount,
+                                    class->superclass ? class->superclass->somethingVariables : NULL,
+                                    class->superclass ? class->superclass->somethingVariableCount : 0, in);
+        readInstanceVariableOffsets(&class->objectVariables, &class->objectVariableCount,
+                                    class->superclass ? class->superclass->objectVariables : NULL,
+                                    class->superclass ? class->superclass->objectVariableCount : 0, in);
         
         class->methodCount = readUInt16(in);
         class->methodsVtable = malloc(sizeof(Function*) * class->methodCount);
@@ -182,15 +218,12 @@ void readPackage(FILE *in){
         uint_fast16_t localMethodCount = readUInt16(in);
         uint_fast16_t localInitializerCount = readUInt16(in);
         
-        if (class != class->superclass) {
+        if (class->superclass) {
             memcpy(class->methodsVtable, class->superclass->methodsVtable, class->superclass->methodCount * sizeof(Function*));
             if (inheritsInitializers) {
                 memcpy(class->initializersVtable, class->superclass->initializersVtable, class->superclass->initializerCount * sizeof(InitializerFunction*));
             }
         }
-        else {
-            class->superclass = NULL;
-        }
         
         for (uint_fast16_t i = 0; i < localMethodCount; i++) {
             readFunction(class->methodsVtable, name, in, hfpMethods);
@@ -220,8 +253,10 @@ void readPackage(FILE *in){
         }
         class->mark = mpfc(name);
         size_t size = sfch(class, name);
+        //The instance variables follow the value area and must be aligned
+        size = (size + 7) & ~(size_t)7;
         class->valueSize = class->superclass && class->superclass->valueSize ? class->superclass->valueSize : size;
-        class->size = class->valueSize + class->instanceVariableCount * sizeof(Something);
+        class->size = class->valueSize + class->instanceVariablesSize;
     }
 }
 
@@ -231,7 +266,8 @@ Function* readBytecode(FILE *in) {
         error("The bytecode file (bcsv %d) is not compatible with this interpreter (bcsv %d).\n", version, ByteCodeSpecificationVersion);
     }
     
-    classTable = malloc(sizeof(Class*) * readUInt16(in));
+    classCount = readUInt16(in);
+    classTable = malloc(sizeof(Class*) * classCount);
     
     for (uint8_t i = 0, l = fgetc(in); i < l; i++) {
         readPackage(in);
@@ -258,13 +294,13 @@ Function* readBytecode(FILE *in) {
     stringPool = malloc(sizeof(Object*) * stringPoolCount);
     for (uint16_t i = 0; i < stringPoolCount; i++) {
         Object *o = newObject(CL_STRING);
-        String *string = o->value;
+        String *string = objectValue(o);
 
         string->length = readUInt16(in);
         string->characters = newArray(string->length * sizeof(EmojicodeChar));
         
         for (uint16_t j = 0; j < string->length; j++) {
-            ((EmojicodeChar*)string->characters->value)[j] = readEmojicodeChar(in);
+            ((EmojicodeChar*)objectValue(string->characters))[j] = readEmojicodeChar(in);
         }
 
         stringPool[i] = o;
@@ -9,41 +9,170 @@
 #include "Emojicode.h"
 #include <string.h>
 
-Something* stackReserveFrame(Something this, uint8_t variableCount, Thread *thread){
-    StackFrame *sf = (StackFrame *)(thread->futureStack - (sizeof(StackFrame) + sizeof(Something) * variableCount));
-    if ((Byte *)sf < thread->stackLimit) {
+/** The size of the first segment of a thread’s VM stack. Every further segment is twice as large as its predecessor. */
+#define initialStackSegmentSize (16 * 1024)
+#define maximalStackSegmentSize (1024 * 1024)
+
+/**
+ * A VM stack consists of a chain of segments. Frames never span segments. Segments that become unused are kept
+ * for reuse until the thread ends.
+ */
+struct StackSegment {
+    StackSegment *previous;
+    StackSegment *next;
+    size_t size;
+};
+
+/** The lowest address in the segment. */
+#define segmentLimit(segment) ((Byte *)(segment) + sizeof(StackSegment))
+/** The address right after the segment, where its first frame ends. */
+#define segmentBottom(segment) (segmentLimit(segment) + (segment)->size)
+
+static StackSegment* allocateStackSegment(StackSegment *previous, size_t size){
+    StackSegment *segment = malloc(sizeof(StackSegment) + size);
+    if (!segment) {
+        error("Could not allocate stack!");
+    }
+    segment->previous = previous;
+    segment->next = NULL;
+    segment->size = size;
+    return segment;
+}
+
+/** The part of the native stack left for natives and error reporting when a stack overflow is detected. */
+#define nativeStackReserve (128 * 1024)
+
+void stackSetNativeStackSize(size_t size, Thread *thread){
+    Byte here;
+    thread->nativeStackLimit = size > nativeStackReserve ? (uintptr_t)&here - (size - nativeStackReserve) : 0;
+}
+
+void stackInitialize(size_t maxSize, Thread *thread){
+    StackSegment *segment = allocateStackSegment(NULL, initialStackSegmentSize);
+    thread->stackSegment = segment;
+    thread->stackLimit = segmentLimit(segment);
+    thread->futureStack = thread->stack = thread->stackBottom = segmentBottom(segment);
+    thread->stackSize = segment->size;
+    thread->maxStackSize = maxSize;
+    thread->nativeStackLimit = 0;
+}
+
+void stackFree(Thread *thread){
+    StackSegment *segment = thread->stackSegment;
+    while (segment->previous) {
+        segment = segment->previous;
+    }
+    while (segment) {
+        StackSegment *next = segment->next;
+        free(segment);
+        segment = next;
+    }
+}
+
+/** Continues the stack in the next segment, which is allocated if necessary. */
+static void stackGrow(Thread *thread){
+    StackSegment *segment = thread->stackSegment;
+    if (!segment->next) {
+        size_t size = segment->size * 2;
+        segment->next = allocateStackSegment(segment, size < maximalStackSegmentSize ? size : maximalStackSegmentSize);
+    }
+    segment = segment->next;
+    
+    if (thread->stackSize + segment->size > thread->maxStackSize) {
+        error("Your program triggerd a stack overflow!");
+    }
+    thread->stackSize += segment->size;
+    thread->stackSegment = segment;
+    thread->stackLimit = segmentLimit(segment);
+}
+
+/** Makes the segment containing @c futureStack the current segment after frames were popped. */
+static void stackSelectSegment(Thread *thread){
+    StackSegment *segment = thread->stackSegment;
+    while (thread->futureStack < segmentLimit(segment) || segmentBottom(segment) < thread->futureStack) {
+        thread->stackSize -= segment->size;
+        segment = segment->previous;
+    }
+    thread->stackSegment = segment;
+    thread->stackLimit = segmentLimit(segment);
+}
+
+/** Reserves a frame of which only the variables from @c argCount on are zeroed. */
+static StackFrame* reserveFrame(Something this, uint8_t variableCount, uint8_t argCount, Thread *thread){
+    //Every call nests native calls too, so deep recursion would overflow the native stack first
+    Byte here;
+    if ((uintptr_t)&here < thread->nativeStackLimit) {
         error("Your program triggerd a stack overflow!");
     }
     
-    memset((Byte *)sf + sizeof(StackFrame), 0, sizeof(Something) * variableCount);
+    size_t frameSize = sizeof(StackFrame) + sizeof(Something) * variableCount;
+    Byte *returnFutureStack = thread->futureStack;
+    StackFrame *sf = (StackFrame *)(thread->futureStack - frameSize);
+    if ((Byte *)sf < thread->stackLimit) {
+        //Even a frame with 255 variables fits into the smallest segment
+        stackGrow(thread);
+        sf = (StackFrame *)(segmentBottom(thread->stackSegment) - frameSize);
+    }
+    
+    memset((Byte *)sf + sizeof(StackFrame) + sizeof(Something) * argCount, 0,
+           sizeof(Something) * (variableCount - argCount));
     
     sf->thisContext = this;
     sf->variableCount = variableCount;
     sf->returnPointer = thread->stack;
-    sf->returnFutureStack = thread->futureStack;
+    sf->returnFutureStack = returnFutureStack;
+    sf->stackMap = NULL;
     
     thread->futureStack = (Byte *)sf;
     
-    return (Something *)(((Byte *)sf) + sizeof(StackFrame));
+    return sf;
+}
+
+#define frameVariables(sf) ((Something *)((Byte *)(sf) + sizeof(StackFrame)))
+
+Something* stackReserveFrame(Something this, uint8_t variableCount, Thread *thread){
+    return frameVariables(reserveFrame(this, variableCount, 0, thread));
+}
+
+Something* stackReserveArgumentFrame(Something this, uint8_t variableCount, uint8_t argCount,
+                                     EmojicodeCoin *stackMap, Thread *thread){
+    StackFrame *sf = reserveFrame(this, variableCount, argCount, thread);
+    sf->stackMap = stackMap;
+    return frameVariables(sf);
 }
 
 void stackPushReservedFrame(Thread *thread){
     thread->stack = thread->futureStack;
 }
 
-void stackPush(Something this, uint8_t variableCount, uint8_t argCount, Thread *thread){
-    Something *t = stackReserveFrame(this, variableCount, thread);
+void stackPushFunction(Something this, uint8_t variableCount, uint8_t argCount, EmojicodeCoin *stackMap,
+                       Thread *thread){
+    StackFrame *sf = reserveFrame(this, variableCount, argCount, thread);
+    Something *t = frameVariables(sf);
     
+    //Evaluating an argument may trigger a garbage collection, which must only see the arguments evaluated so far.
+    //The zeroed variables after the arguments need not be visited until the frame is complete.
+    sf->variableCount = 0;
     for (uint8_t i = 0; i < argCount; i++) {
         t[i] = parse(consumeCoin(thread), thread);
+        sf->variableCount = i + 1;
     }
+    sf->variableCount = variableCount;
+    sf->stackMap = stackMap;
     
     stackPushReservedFrame(thread);
 }
 
+void stackPush(Something this, uint8_t variableCount, uint8_t argCount, Thread *thread){
+    stackPushFunction(this, variableCount, argCount, NULL, thread);
+}
+
 void stackPop(Thread *thread) {
     thread->futureStack = ((StackFrame *)thread->stack)->returnFutureStack;
     thread->stack = ((StackFrame *)thread->stack)->returnPointer;
+    if (thread->futureStack < thread->stackLimit || segmentBottom(thread->stackSegment) < thread->futureStack) {
+        stackSelectSegment(thread);
+    }
 }
 
 StackState storeStackState(Thread *thread) {
@@ -54,6 +183,7 @@ StackState storeStackState(Thread *thread) {
 void restoreStackState(StackState s, Thread *thread) {
     thread->futureStack = s.futureStack;
     thread->stack = s.stack;
+    stackSelectSegment(thread);
 }
 
 Something stackGetVariable(uint8_t index, Thread *thread){
@@ -85,11 +215,23 @@ Class* stackGetThisObjectClass(Thread *thread){
 }
 
 void stackMark(Thread *thread){
-    for (StackFrame *stackFrame = (StackFrame *)thread->futureStack; (Byte *)stackFrame < thread->stackBottom; stackFrame = stackFrame->returnFutureStack) {
-        for (uint8_t i = 0; i < stackFrame->variableCount; i++) {
-            Something *s = (Something *)(((Byte *)stackFrame) + sizeof(StackFrame) + sizeof(Something) * i);
-            if (isRealObject(*s)) {
-                mark(&s->object);
+    //The frames are linked across segments, the bottom of the first segment terminates the chain
+    for (StackFrame *stackFrame = (StackFrame *)thread->futureStack; (Byte *)stackFrame != thread->stackBottom; stackFrame = stackFrame->returnFutureStack) {
+        Something *variables = frameVariables(stackFrame);
+        if (stackFrame->stackMap) {
+            //Frames of functions without reference variables are skipped after this check
+            for (EmojicodeCoin i = 1; i <= stackFrame->stackMap[0]; i++) {
+                Something *s = variables + stackFrame->stackMap[i];
+                if (isRealObject(*s)) {
+                    mark(&s->object);
+                }
+            }
+        }
+        else {
+            for (uint8_t i = 0; i < stackFrame->variableCount; i++) {
+                if (isRealObject(variables[i])) {
+                    mark(&variables[i].object);
+                }
             }
         }
         if (isRealObject(stackFrame->thisContext)) {
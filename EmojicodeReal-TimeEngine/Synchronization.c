@@ -0,0 +1,274 @@
+//
+//  Synchronization.c
+//  Emojicode
+//
+//  Reader-writer locks, condition variables and semaphores built on futexes. Acquiring them takes a single atomic
+//  operation unless they are contended. Their state lives outside the heap, because threads sleep on it.
+//
+
+#include "Emojicode.h"
+#include <unistd.h>
+
+/** Sleeps while @c address contains @c value. The GC may run meanwhile. */
+static void waitAllowingGC(_Atomic uint32_t *address, uint32_t value){
+    allowGC();
+    futexWait(address, value);
+    disallowGCAndPauseIfNeeded();
+}
+
+static void* allocateState(size_t size){
+    void *state = calloc(1, size);
+    if (!state) {
+        error("Could not allocate synchronization primitive!");
+    }
+    return state;
+}
+
+#define stateForThis(type, thread) (*(type **)objectValue(stackGetThisObject(thread)))
+
+//MARK: Reader-writer locks
+
+/** Set in the state of a 🚦 while a writer holds it. The remaining bits count the readers holding it. */
+#define rwLockWriter 0x80000000u
+
+typedef struct {
+    _Atomic uint32_t state;
+    /** Readers do not acquire the lock while writers are waiting, so that a stream of readers cannot starve them. */
+    _Atomic uint32_t waitingWriters;
+    /**
+     * Incremented by every unlock that leaves the lock free, waiting threads sleep on it. @c state cannot be slept on,
+     * as a writer that locks and unlocks in between returns it to the value the waiter saw.
+     */
+    _Atomic uint32_t generation;
+    /** The number of threads sleeping on @c generation. */
+    _Atomic uint32_t waiters;
+} RWLock;
+
+static void initRWLock(Thread *thread){
+    stateForThis(RWLock, thread) = allocateState(sizeof(RWLock));
+}
+
+static bool rwLockReadable(RWLock *lock, uint32_t state){
+    return !(state & rwLockWriter) && !atomic_load(&lock->waitingWriters);
+}
+
+static Something rwLockLockReading(Thread *thread){
+    RWLock *lock = stateForThis(RWLock, thread);
+    while (true) {
+        uint32_t state = atomic_load(&lock->state);
+        if (rwLockReadable(lock, state)) {
+            if (atomic_compare_exchange_weak(&lock->state, &state, state + 1)) {
+                return NOTHINGNESS;
+            }
+            continue;
+        }
+        atomic_fetch_add(&lock->waiters, 1);
+        //A thread that unlocks after these loads changes the generation and sees the waiter
+        uint32_t generation = atomic_load(&lock->generation);
+        state = atomic_load(&lock->state);
+        if (!rwLockReadable(lock, state)) {
+            waitAllowingGC(&lock->generation, generation);
+        }
+        atomic_fetch_sub(&lock->waiters, 1);
+    }
+}
+
+static Something rwLockUnlockReading(Thread *thread){
+    RWLock *lock = stateForThis(RWLock, thread);
+    if (atomic_fetch_sub(&lock->state, 1) == 1) {
+        atomic_fetch_add(&lock->generation, 1);
+        if (atomic_load(&lock->waiters)) {
+            futexWake(&lock->generation);
+        }
+    }
+    return NOTHINGNESS;
+}
+
+static Something rwLockLock(Thread *thread){
+    RWLock *lock = stateForThis(RWLock, thread);
+    uint32_t expected = 0;
+    if (atomic_compare_exchange_strong(&lock->state, &expected, rwLockWriter)) {
+        return NOTHINGNESS;
+    }
+    atomic_fetch_add(&lock->waitingWriters, 1);
+    while (true) {
+        expected = 0;
+        if (atomic_compare_exchange_strong(&lock->state, &expected, rwLockWriter)) {
+            break;
+        }
+        atomic_fetch_add(&lock->waiters, 1);
+        uint32_t generation = atomic_load(&lock->generation);
+        if (atomic_load(&lock->state)) {
+            waitAllowingGC(&lock->generation, generation);
+        }
+        atomic_fetch_sub(&lock->waiters, 1);
+    }
+    atomic_fetch_sub(&lock->waitingWriters, 1);
+    return NOTHINGNESS;
+}
+
+static Something rwLockUnlock(Thread *thread){
+    RWLock *lock = stateForThis(RWLock, thread);
+    atomic_store(&lock->state, 0);
+    atomic_fetch_add(&lock->generation, 1);
+    if (atomic_load(&lock->waiters)) {
+        futexWake(&lock->generation);
+    }
+    return NOTHINGNESS;
+}
+
+//MARK: Condition variables
+
+typedef struct {
+    /** Incremented by every signal, waiting threads sleep on it. */
+    _Atomic uint32_t sequence;
+    _Atomic uint32_t waiters;
+} Condition;
+
+static void initCondition(Thread *thread){
+    stateForThis(Condition, thread) = allocateState(sizeof(Condition));
+}
+
+static Something conditionWait(Thread *thread){
+    Condition *condition = stateForThis(Condition, thread);
+    atomic_fetch_add(&condition->waiters, 1);
+    //A signal sent after the mutex was unlocked changes the sequence and the futex does not block
+    uint32_t sequence = atomic_load(&condition->sequence);
+    pthread_mutex_unlock(objectValue(stackGetVariable(0, thread).object));
+    waitAllowingGC(&condition->sequence, sequence);
+    atomic_fetch_sub(&condition->waiters, 1);
+
+    //The 🔐 may have been moved, it is locked like 🔒 does
+    while (pthread_mutex_trylock(objectValue(stackGetVariable(0, thread).object)) != 0) {
+        pauseForGC(NULL);
+        usleep(10);
+    }
+    return NOTHINGNESS;
+}
+
+static Something conditionSignal(Thread *thread){
+    Condition *condition = stateForThis(Condition, thread);
+    if (atomic_load(&condition->waiters)) {
+        atomic_fetch_add(&condition->sequence, 1);
+        futexWakeOne(&condition->sequence);
+    }
+    return NOTHINGNESS;
+}
+
+static Something conditionBroadcast(Thread *thread){
+    Condition *condition = stateForThis(Condition, thread);
+    if (atomic_load(&condition->waiters)) {
+        atomic_fetch_add(&condition->sequence, 1);
+        futexWake(&condition->sequence);
+    }
+    return NOTHINGNESS;
+}
+
+//MARK: Semaphores
+
+typedef struct {
+    _Atomic uint32_t count;
+    _Atomic uint32_t waiters;
+} Semaphore;
+
+static void initSemaphore(Thread *thread){
+    EmojicodeInteger count = unwrapInteger(stackGetVariable(0, thread));
+    Semaphore *semaphore = allocateState(sizeof(Semaphore));
+    atomic_init(&semaphore->count, count > 0 ? (count < UINT32_MAX ? (uint32_t)count : UINT32_MAX) : 0);
+    stateForThis(Semaphore, thread) = semaphore;
+}
+
+static bool semaphoreTryDecrement(Semaphore *semaphore){
+    uint32_t count = atomic_load(&semaphore->count);
+    while (count > 0) {
+        if (atomic_compare_exchange_weak(&semaphore->count, &count, count - 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static Something semaphoreAcquire(Thread *thread){
+    Semaphore *semaphore = stateForThis(Semaphore, thread);
+    while (!semaphoreTryDecrement(semaphore)) {
+        atomic_fetch_add(&semaphore->waiters, 1);
+        if (atomic_load(&semaphore->count) == 0) {
+            waitAllowingGC(&semaphore->count, 0);
+        }
+        atomic_fetch_sub(&semaphore->waiters, 1);
+    }
+    return NOTHINGNESS;
+}
+
+static Something semaphoreTryAcquire(Thread *thread){
+    return semaphoreTryDecrement(stateForThis(Semaphore, thread)) ? EMOJICODE_TRUE : EMOJICODE_FALSE;
+}
+
+static Something semaphoreRelease(Thread *thread){
+    Semaphore *semaphore = stateForThis(Semaphore, thread);
+    atomic_fetch_add(&semaphore->count, 1);
+    if (atomic_load(&semaphore->waiters)) {
+        futexWakeOne(&semaphore->count);
+    }
+    return NOTHINGNESS;
+}
+
+static Something semaphoreCount(Thread *thread){
+    return somethingInteger(atomic_load(&stateForThis(Semaphore, thread)->count));
+}
+
+void synchronizationDeinitialize(void *value){
+    free(*(void **)value);
+}
+
+FunctionFunctionPointer synchronizationMethodForName(EmojicodeChar cl, EmojicodeChar name){
+    switch (cl) {
+        case 0x1f6a6: //🚦
+            switch (name) {
+                case 0x1f4d6: //📖
+                    return rwLockLockReading;
+                case 0x1f4d5: //📕
+                    return rwLockUnlockReading;
+                case 0x1f512: //🔒
+                    return rwLockLock;
+                case 0x1f513: //🔓
+                    return rwLockUnlock;
+            }
+            return NULL;
+        case 0x1f514: //🔔
+            switch (name) {
+                case 0x23f3: //⏳
+                    return conditionWait;
+                case 0x1f4e3: //📣
+                    return conditionSignal;
+                case 0x1f4e2: //📢
+                    return conditionBroadcast;
+            }
+            return NULL;
+        case 0x1f6a5: //🚥
+            switch (name) {
+                case 0x2b07: //⬇️
+                    return semaphoreAcquire;
+                case 0x1f53d: //🔽
+                    return semaphoreTryAcquire;
+                case 0x2b06: //⬆️
+                    return semaphoreRelease;
+                case 0x1f414: //🐔
+                    return semaphoreCount;
+            }
+            return NULL;
+    }
+    return NULL;
+}
+
+InitializerFunctionFunctionPointer synchronizationInitializerForName(EmojicodeChar cl){
+    switch (cl) {
+        case 0x1f6a6: //🚦
+            return initRWLock;
+        case 0x1f514: //🔔
+            return initCondition;
+        case 0x1f6a5: //🚥
+            return initSemaphore;
+    }
+    return NULL;
+}
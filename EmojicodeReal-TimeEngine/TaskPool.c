@@ -0,0 +1,656 @@
+//
+//  TaskPool.c
+//  Emojicode
+//
+//  A fixed-size pool of worker threads with one work-stealing deque per worker.
+//
+
+#include "Emojicode.h"
+#include <string.h>
+#include <unistd.h>
+
+typedef struct TaskBuffer {
+    /** Always a power of two. */
+    size_t capacity;
+    /** Buffers replaced by a bigger one, which may still be read by stealing threads. */
+    struct TaskBuffer *retired;
+    _Atomic(Object *) tasks[];
+} TaskBuffer;
+
+/**
+ * A deque as described by Chase and Lev (“Dynamic Circular Work-Stealing Deque”) using the memory orderings proposed
+ * by Lê et al. (“Correct and Efficient Work-Stealing for Weak Memory Models”). Only the owning worker pushes and pops
+ * at the bottom, other workers steal from the top.
+ */
+typedef struct {
+    _Atomic int64_t top;
+    _Atomic int64_t bottom;
+    _Atomic(TaskBuffer *) buffer;
+} TaskDeque;
+
+typedef struct {
+    TaskPool *pool;
+    Thread *thread;
+    TaskDeque deque;
+    size_t index;
+} Worker;
+
+/**
+ * Work split into chunks, which the submitting thread and the pool’s workers claim one after another. The job is
+ * queued as tickets, pointers to the job with the lowest bit set, so that idle workers join in.
+ */
+typedef struct Job {
+    TaskPool *pool;
+    TaskPoolChunkFunction function;
+    void *context;
+    size_t chunkCount;
+    _Atomic size_t nextChunk;
+    _Atomic size_t finishedChunks;
+    /** One reference for the submitting thread and one for every ticket. */
+    _Atomic size_t references;
+    struct Job *jobBefore;
+    struct Job *jobAfter;
+    size_t objectCount;
+    /** Marked by the GC as long as the job exists. */
+    Object *objects[];
+} Job;
+
+#define isJobTicket(task) ((uintptr_t)(task) & 1)
+#define jobForTicket(task) ((Job *)((uintptr_t)(task) & ~(uintptr_t)1))
+
+struct TaskPool {
+    Worker *workers;
+    size_t workerCount;
+
+    pthread_mutex_t mutex;
+    /** Idle workers and workers waiting for a task to finish wait for new tasks. */
+    pthread_cond_t workAvailable;
+    /** Threads that are not workers of this pool wait for tasks to finish. */
+    pthread_cond_t taskFinished;
+
+    /** Tasks submitted by threads that are not workers of this pool, a ring buffer protected by @c mutex. */
+    Object **injected;
+    size_t injectedStart;
+    size_t injectedCapacity;
+    /** The number of injected tasks. Only changed while holding @c mutex. */
+    _Atomic size_t injectedCount;
+
+    /** The number of tasks submitted but not yet taken by a worker. */
+    _Atomic int64_t queued;
+    /** The number of tasks finished. */
+    _Atomic uint64_t completions;
+    /** The number of threads waiting on @c workAvailable. */
+    _Atomic uint32_t sleepers;
+    /** The number of workers waiting on @c workAvailable for a task to finish. */
+    _Atomic uint32_t helpers;
+    /** The number of threads waiting on @c taskFinished. */
+    _Atomic uint32_t joiners;
+    /** Set once the 🏊 object was finalized. Protected by @c mutex. */
+    bool shutdown;
+
+    /** The jobs that are running. Protected by @c mutex. */
+    Job *lastJob;
+
+    /** One reference for the 🏊 object, one for every worker and one for every thread joining a task. */
+    _Atomic size_t references;
+
+    TaskPool *poolBefore;
+    TaskPool *poolAfter;
+};
+
+/** All pools whose tasks must be marked by the GC. */
+static TaskPool *lastPool = NULL;
+static pthread_mutex_t poolsMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/** The worker running on the current OS thread or @c NULL. */
+static _Thread_local Worker *currentWorker = NULL;
+
+//MARK: Deque
+
+static TaskBuffer* taskBufferNew(size_t capacity){
+    TaskBuffer *buffer = malloc(sizeof(TaskBuffer) + capacity * sizeof(_Atomic(Object *)));
+    if (!buffer) {
+        error("Could not allocate task deque!");
+    }
+    buffer->capacity = capacity;
+    buffer->retired = NULL;
+    return buffer;
+}
+
+static void dequeInitialize(TaskDeque *deque){
+    atomic_init(&deque->top, 0);
+    atomic_init(&deque->bottom, 0);
+    atomic_init(&deque->buffer, taskBufferNew(64));
+}
+
+static void dequeFree(TaskDeque *deque){
+    TaskBuffer *buffer = atomic_load_explicit(&deque->buffer, memory_order_relaxed);
+    while (buffer) {
+        TaskBuffer *retired = buffer->retired;
+        free(buffer);
+        buffer = retired;
+    }
+}
+
+/** Must only be called by the owning worker. */
+static void dequePush(TaskDeque *deque, Object *task){
+    int64_t b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    int64_t t = atomic_load_explicit(&deque->top, memory_order_acquire);
+    TaskBuffer *buffer = atomic_load_explicit(&deque->buffer, memory_order_relaxed);
+    if (b - t > (int64_t)buffer->capacity - 1) {
+        TaskBuffer *grown = taskBufferNew(buffer->capacity * 2);
+        for (int64_t i = t; i < b; i++) {
+            Object *o = atomic_load_explicit(&buffer->tasks[i & (buffer->capacity - 1)], memory_order_relaxed);
+            atomic_store_explicit(&grown->tasks[i & (grown->capacity - 1)], o, memory_order_relaxed);
+        }
+        //Stealing threads may still read the old buffer, it is freed by the GC once all threads are stopped
+        grown->retired = buffer;
+        atomic_store_explicit(&deque->buffer, grown, memory_order_release);
+        buffer = grown;
+    }
+    atomic_store_explicit(&buffer->tasks[b & (buffer->capacity - 1)], task, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+}
+
+/** Must only be called by the owning worker. */
+static Object* dequePop(TaskDeque *deque){
+    int64_t b = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    TaskBuffer *buffer = atomic_load_explicit(&deque->buffer, memory_order_relaxed);
+    atomic_store_explicit(&deque->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+    if (t > b) {
+        atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+        return NULL;
+    }
+    Object *task = atomic_load_explicit(&buffer->tasks[b & (buffer->capacity - 1)], memory_order_relaxed);
+    if (t == b) {
+        //The last task, which a stealing thread may take at the same time
+        if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1, memory_order_seq_cst,
+                                                     memory_order_relaxed)) {
+            task = NULL;
+        }
+        atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+    }
+    return task;
+}
+
+/** Returns @c NULL if the deque is empty or another thread took the task first. */
+static Object* dequeSteal(TaskDeque *deque){
+    int64_t t = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t b = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+    if (t >= b) {
+        return NULL;
+    }
+    TaskBuffer *buffer = atomic_load_explicit(&deque->buffer, memory_order_acquire);
+    Object *task = atomic_load_explicit(&buffer->tasks[t & (buffer->capacity - 1)], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1, memory_order_seq_cst,
+                                                 memory_order_relaxed)) {
+        return NULL;
+    }
+    return task;
+}
+
+//MARK: Pool
+
+static void taskPoolRelease(TaskPool *pool){
+    if (atomic_fetch_sub(&pool->references, 1) != 1) {
+        return;
+    }
+    pthread_mutex_lock(&poolsMutex);
+    if (pool->poolBefore) pool->poolBefore->poolAfter = pool->poolAfter;
+    if (pool->poolAfter) pool->poolAfter->poolBefore = pool->poolBefore;
+    if (lastPool == pool) lastPool = pool->poolBefore;
+    pthread_mutex_unlock(&poolsMutex);
+
+    for (size_t i = 0; i < pool->workerCount; i++) {
+        dequeFree(&pool->workers[i].deque);
+    }
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->workAvailable);
+    pthread_cond_destroy(&pool->taskFinished);
+    free(pool->injected);
+    free(pool->workers);
+    free(pool);
+}
+
+/** Wakes an idle worker if there is one. Must be called after a task was made available. */
+static void taskPoolNotify(TaskPool *pool){
+    atomic_fetch_add(&pool->queued, 1);
+    //A worker going to sleep increments sleepers before it checks queued
+    if (atomic_load(&pool->sleepers)) {
+        pthread_mutex_lock(&pool->mutex);
+        pthread_cond_signal(&pool->workAvailable);
+        pthread_mutex_unlock(&pool->mutex);
+    }
+}
+
+static void taskPoolSubmit(TaskPool *pool, Object *task){
+    if (currentWorker && currentWorker->pool == pool) {
+        dequePush(&currentWorker->deque, task);
+    }
+    else {
+        pthread_mutex_lock(&pool->mutex);
+        size_t count = atomic_load_explicit(&pool->injectedCount, memory_order_relaxed);
+        if (count == pool->injectedCapacity) {
+            size_t capacity = pool->injectedCapacity ? pool->injectedCapacity * 2 : 64;
+            Object **injected = malloc(capacity * sizeof(Object *));
+            if (!injected) {
+                pthread_mutex_unlock(&pool->mutex);
+                error("Could not allocate task queue!");
+            }
+            for (size_t i = 0; i < count; i++) {
+                injected[i] = pool->injected[(pool->injectedStart + i) % pool->injectedCapacity];
+            }
+            free(pool->injected);
+            pool->injected = injected;
+            pool->injectedStart = 0;
+            pool->injectedCapacity = capacity;
+        }
+        pool->injected[(pool->injectedStart + count) % pool->injectedCapacity] = task;
+        atomic_store_explicit(&pool->injectedCount, count + 1, memory_order_relaxed);
+        pthread_mutex_unlock(&pool->mutex);
+    }
+    taskPoolNotify(pool);
+}
+
+/** Takes a task from the worker’s own deque, the injected tasks or another worker’s deque. */
+static Object* taskPoolTake(Worker *worker){
+    TaskPool *pool = worker->pool;
+    Object *task = dequePop(&worker->deque);
+
+    if (!task && atomic_load_explicit(&pool->injectedCount, memory_order_relaxed)) {
+        pthread_mutex_lock(&pool->mutex);
+        size_t count = atomic_load_explicit(&pool->injectedCount, memory_order_relaxed);
+        if (count) {
+            task = pool->injected[pool->injectedStart];
+            pool->injectedStart = (pool->injectedStart + 1) % pool->injectedCapacity;
+            atomic_store_explicit(&pool->injectedCount, count - 1, memory_order_relaxed);
+        }
+        pthread_mutex_unlock(&pool->mutex);
+    }
+
+    for (size_t i = 1; !task && i < pool->workerCount; i++) {
+        task = dequeSteal(&pool->workers[(worker->index + i) % pool->workerCount].deque);
+    }
+
+    if (task) {
+        atomic_fetch_sub(&pool->queued, 1);
+    }
+    return task;
+}
+
+/** Wakes the threads waiting for a task or a job to finish. */
+static void taskPoolCompleted(TaskPool *pool){
+    atomic_fetch_add(&pool->completions, 1);
+    //Joining threads increment joiners or helpers before they check completions
+    if (atomic_load(&pool->joiners) || atomic_load(&pool->helpers)) {
+        pthread_mutex_lock(&pool->mutex);
+        pthread_cond_broadcast(&pool->taskFinished);
+        if (atomic_load(&pool->helpers)) {
+            pthread_cond_broadcast(&pool->workAvailable);
+        }
+        pthread_mutex_unlock(&pool->mutex);
+    }
+}
+
+static void jobRelease(Job *job){
+    if (atomic_fetch_sub(&job->references, 1) != 1) {
+        return;
+    }
+    TaskPool *pool = job->pool;
+    pthread_mutex_lock(&pool->mutex);
+    if (job->jobBefore) job->jobBefore->jobAfter = job->jobAfter;
+    if (job->jobAfter) job->jobAfter->jobBefore = job->jobBefore;
+    if (pool->lastJob == job) pool->lastJob = job->jobBefore;
+    pthread_mutex_unlock(&pool->mutex);
+    free(job);
+}
+
+/** Runs chunks of the job until all chunks have been claimed. */
+static void jobRunChunks(Job *job, Thread *thread){
+    size_t chunk;
+    while ((chunk = atomic_fetch_add(&job->nextChunk, 1)) < job->chunkCount) {
+        job->function(job->objects, job->context, chunk, thread);
+        if (atomic_fetch_add(&job->finishedChunks, 1) + 1 == job->chunkCount) {
+            taskPoolCompleted(job->pool);
+        }
+    }
+}
+
+static void taskRun(Object *task, Thread *thread){
+    if (isJobTicket(task)) {
+        Job *job = jobForTicket(task);
+        jobRunChunks(job, thread);
+        jobRelease(job);
+        return;
+    }
+    if (task->class == CL_CLOSURE || task->class == CL_CAPTURED_FUNCTION_CALL) {
+        //Submitted by taskPoolSubmitCallable, nobody waits for it
+        executeCallableExtern(task, NULL, thread);
+        return;
+    }
+    stackPush(somethingObject(task), 0, 0, thread);
+    executeCallableExtern(((Task *)objectValue(task))->callable, NULL, thread);
+    Task *t = objectValue(stackGetThisObject(thread));
+    stackPop(thread);
+
+    writeBarrier(t->callable);
+    t->callable = NULL;
+    atomic_store(&t->finished, true);
+    taskPoolCompleted(t->pool);
+}
+
+/**
+ * Blocks until @c finished returns true. A worker of the pool runs other tasks of the pool in the meantime, any other
+ * thread sleeps and does not hold up GC cycles.
+ */
+static void taskPoolAwait(TaskPool *pool, bool (*finished)(void *context, Thread *thread), void *context,
+                          Thread *thread){
+    Worker *worker = currentWorker && currentWorker->pool == pool ? currentWorker : NULL;
+    while (!finished(context, thread)) {
+        Object *other;
+        if (worker && (other = taskPoolTake(worker))) {
+            taskRun(other, thread);
+            continue;
+        }
+
+        uint64_t completions = atomic_load(&pool->completions);
+        if (finished(context, thread)) {
+            break;
+        }
+        //The task has not finished, so a worker still holds a reference
+        atomic_fetch_add(&pool->references, 1);
+        allowGC();
+        pthread_mutex_lock(&pool->mutex);
+        if (worker) {
+            atomic_fetch_add(&pool->helpers, 1);
+            atomic_fetch_add(&pool->sleepers, 1);
+            while (atomic_load(&pool->completions) == completions && atomic_load(&pool->queued) <= 0) {
+                pthread_cond_wait(&pool->workAvailable, &pool->mutex);
+            }
+            atomic_fetch_sub(&pool->sleepers, 1);
+            atomic_fetch_sub(&pool->helpers, 1);
+        }
+        else {
+            atomic_fetch_add(&pool->joiners, 1);
+            while (atomic_load(&pool->completions) == completions) {
+                pthread_cond_wait(&pool->taskFinished, &pool->mutex);
+            }
+            atomic_fetch_sub(&pool->joiners, 1);
+        }
+        pthread_mutex_unlock(&pool->mutex);
+        disallowGCAndPauseIfNeeded();
+        taskPoolRelease(pool);
+    }
+}
+
+/**
+ * Blocks an idle worker until a task might be available. Returns false if the pool was shut down and no tasks are
+ * left. The worker does not hold up GC cycles while it waits.
+ */
+static bool taskPoolWait(TaskPool *pool){
+    bool running = true;
+    allowGC();
+    pthread_mutex_lock(&pool->mutex);
+    atomic_fetch_add(&pool->sleepers, 1);
+    while (atomic_load(&pool->queued) <= 0) {
+        if (pool->shutdown) {
+            running = false;
+            break;
+        }
+        pthread_cond_wait(&pool->workAvailable, &pool->mutex);
+    }
+    atomic_fetch_sub(&pool->sleepers, 1);
+    pthread_mutex_unlock(&pool->mutex);
+    disallowGCAndPauseIfNeeded();
+    return running;
+}
+
+static void* workerStarter(void *workerv){
+    Worker *worker = workerv;
+    TaskPool *pool = worker->pool;
+    currentThread = worker->thread;
+    currentWorker = worker;
+    disallowGCAndPauseIfNeeded();
+    stackSetNativeStackSize(worker->thread->maxStackSize, worker->thread);
+
+    do {
+        Object *task;
+        while ((task = taskPoolTake(worker))) {
+            taskRun(task, worker->thread);
+        }
+    } while (taskPoolWait(pool));
+
+    currentWorker = NULL;
+    Thread *thread = worker->thread;
+    taskPoolRelease(pool);
+    removeThread(thread);
+    return NULL;
+}
+
+void taskPoolsMark(){
+    pthread_mutex_lock(&poolsMutex);
+    for (TaskPool *pool = lastPool; pool != NULL; pool = pool->poolBefore) {
+        for (size_t i = 0; i < pool->workerCount; i++) {
+            TaskDeque *deque = &pool->workers[i].deque;
+            TaskBuffer *buffer = atomic_load_explicit(&deque->buffer, memory_order_relaxed);
+            int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+            for (int64_t j = atomic_load_explicit(&deque->top, memory_order_relaxed); j < bottom; j++) {
+                _Atomic(Object *) *slot = &buffer->tasks[j & (buffer->capacity - 1)];
+                Object *task = atomic_load_explicit(slot, memory_order_relaxed);
+                if (!isJobTicket(task)) {
+                    mark(&task);
+                    atomic_store_explicit(slot, task, memory_order_relaxed);
+                }
+            }
+            //No thread can be stealing from a retired buffer while all threads are stopped
+            TaskBuffer *retired = buffer->retired;
+            buffer->retired = NULL;
+            while (retired) {
+                TaskBuffer *next = retired->retired;
+                free(retired);
+                retired = next;
+            }
+        }
+        size_t count = atomic_load_explicit(&pool->injectedCount, memory_order_relaxed);
+        for (size_t i = 0; i < count; i++) {
+            Object **task = &pool->injected[(pool->injectedStart + i) % pool->injectedCapacity];
+            if (!isJobTicket(*task)) {
+                mark(task);
+            }
+        }
+        for (Job *job = pool->lastJob; job != NULL; job = job->jobBefore) {
+            for (size_t i = 0; i < job->objectCount; i++) {
+                mark(&job->objects[i]);
+            }
+        }
+    }
+    pthread_mutex_unlock(&poolsMutex);
+}
+
+void taskPoolSubmitCallable(Object *pool, Object *callable){
+    taskPoolSubmit(*(TaskPool **)objectValue(pool), callable);
+}
+
+size_t taskPoolChunkCount(Object *pool, size_t itemCount){
+    //More chunks than workers balance chunks that take longer than others
+    size_t chunkCount = (*(TaskPool **)objectValue(pool))->workerCount * 4;
+    return itemCount < chunkCount ? itemCount : chunkCount;
+}
+
+static bool jobFinished(void *job, Thread *thread){
+    return atomic_load(&((Job *)job)->finishedChunks) == ((Job *)job)->chunkCount;
+}
+
+void taskPoolRunChunks(Object *poolObject, size_t chunkCount, TaskPoolChunkFunction function, Object **objects,
+                       size_t objectCount, void *context, Thread *thread){
+    if (chunkCount == 0) {
+        return;
+    }
+    TaskPool *pool = *(TaskPool **)objectValue(poolObject);
+    Job *job = malloc(sizeof(Job) + objectCount * sizeof(Object *));
+    if (!job) {
+        error("Could not allocate job!");
+    }
+    job->pool = pool;
+    job->function = function;
+    job->context = context;
+    job->chunkCount = chunkCount;
+    atomic_init(&job->nextChunk, 0);
+    atomic_init(&job->finishedChunks, 0);
+    size_t tickets = chunkCount - 1 < pool->workerCount ? chunkCount - 1 : pool->workerCount;
+    atomic_init(&job->references, tickets + 1);
+    job->jobAfter = NULL;
+    job->objectCount = objectCount;
+    memcpy(job->objects, objects, objectCount * sizeof(Object *));
+
+    pthread_mutex_lock(&pool->mutex);
+    job->jobBefore = pool->lastJob;
+    if (pool->lastJob) {
+        pool->lastJob->jobAfter = job;
+    }
+    pool->lastJob = job;
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (size_t i = 0; i < tickets; i++) {
+        taskPoolSubmit(pool, (Object *)((uintptr_t)job | 1));
+    }
+    jobRunChunks(job, thread);
+    taskPoolAwait(pool, jobFinished, job, thread);
+
+    memcpy(objects, job->objects, objectCount * sizeof(Object *));
+    jobRelease(job);
+}
+
+//MARK: Bridges
+
+static void initTaskPoolWithWorkers(Thread *thread, size_t workerCount){
+    TaskPool *pool = calloc(1, sizeof(TaskPool));
+    Worker *workers = calloc(workerCount, sizeof(Worker));
+    if (!pool || !workers) {
+        error("Could not allocate task pool!");
+    }
+    pool->workers = workers;
+    pool->workerCount = workerCount;
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->workAvailable, NULL);
+    pthread_cond_init(&pool->taskFinished, NULL);
+    atomic_init(&pool->references, workerCount + 1);
+    *(TaskPool **)objectValue(stackGetThisObject(thread)) = pool;
+
+    for (size_t i = 0; i < workerCount; i++) {
+        workers[i].pool = pool;
+        workers[i].index = i;
+        dequeInitialize(&workers[i].deque);
+        workers[i].thread = allocateThread(defaultMaxStackSize);
+    }
+
+    pthread_mutex_lock(&poolsMutex);
+    pool->poolBefore = lastPool;
+    if (lastPool) {
+        lastPool->poolAfter = pool;
+    }
+    lastPool = pool;
+    pthread_mutex_unlock(&poolsMutex);
+
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setstacksize(&attributes, defaultMaxStackSize);
+    pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+    for (size_t i = 0; i < workerCount; i++) {
+        pthread_t pthread;
+        if (pthread_create(&pthread, &attributes, workerStarter, &workers[i]) != 0) {
+            error("Could not start worker thread!");
+        }
+    }
+    pthread_attr_destroy(&attributes);
+}
+
+static void initTaskPool(Thread *thread){
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    initTaskPoolWithWorkers(thread, processors > 0 ? (size_t)processors : 1);
+}
+
+static void initTaskPoolWorkers(Thread *thread){
+    EmojicodeInteger workers = unwrapInteger(stackGetVariable(0, thread));
+    initTaskPoolWithWorkers(thread, workers > 0 ? (size_t)workers : 1);
+}
+
+static Something taskPoolWorkers(Thread *thread){
+    return somethingInteger((EmojicodeInteger)(*(TaskPool **)objectValue(stackGetThisObject(thread)))->workerCount);
+}
+
+void taskPoolDeinitialize(void *value){
+    TaskPool *pool = *(TaskPool **)value;
+    //The workers finish the remaining tasks and exit
+    pthread_mutex_lock(&pool->mutex);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->workAvailable);
+    pthread_mutex_unlock(&pool->mutex);
+    taskPoolRelease(pool);
+}
+
+static void initTask(Thread *thread){
+    Object *task = stackGetThisObject(thread);
+    Task *t = objectValue(task);
+    t->pool = *(TaskPool **)objectValue(stackGetVariable(0, thread).object);
+    t->callable = stackGetVariable(1, thread).object;
+    atomic_init(&t->finished, false);
+    taskPoolSubmit(t->pool, task);
+}
+
+static Something taskIsFinished(Thread *thread){
+    Task *t = objectValue(stackGetThisObject(thread));
+    return atomic_load(&t->finished) ? EMOJICODE_TRUE : EMOJICODE_FALSE;
+}
+
+static bool taskFinished(void *context, Thread *thread){
+    //The task may move whenever another task runs or the GC is allowed to run
+    return atomic_load(&((Task *)objectValue(stackGetThisObject(thread)))->finished);
+}
+
+static Something taskJoin(Thread *thread){
+    taskPoolAwait(((Task *)objectValue(stackGetThisObject(thread)))->pool, taskFinished, NULL, thread);
+    return NOTHINGNESS;
+}
+
+void taskMark(Object *o){
+    Task *t = objectValue(o);
+    if (t->callable) {
+        mark(&t->callable);
+    }
+}
+
+FunctionFunctionPointer taskPoolMethodForName(EmojicodeChar name){
+    switch (name) {
+        case 0x1f414: //🐔
+            return taskPoolWorkers;
+    }
+    return NULL;
+}
+
+InitializerFunctionFunctionPointer taskPoolInitializerForName(EmojicodeChar name){
+    switch (name) {
+        case 0x1f477: //👷
+            return initTaskPoolWorkers;
+    }
+    return initTaskPool;
+}
+
+FunctionFunctionPointer taskMethodForName(EmojicodeChar name){
+    switch (name) {
+        case 0x1f6c2: //🛂
+            return taskJoin;
+        case 0x2705: //✅
+            return taskIsFinished;
+    }
+    return NULL;
+}
+
+InitializerFunctionFunctionPointer taskInitializerForName(EmojicodeChar name){
+    return initTask;
+}
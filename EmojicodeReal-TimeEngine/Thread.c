@@ -10,19 +10,23 @@
 #include <pthread.h>
 
 Thread *lastThread = NULL;
+_Thread_local Thread *currentThread = NULL;
 int threads = 0;
 pthread_mutex_t threadListMutex = PTHREAD_MUTEX_INITIALIZER;
 
-Thread* allocateThread() {
-#define stackSize (sizeof(StackFrame) + 4 * sizeof(Something)) * 10000 //ca. 400 KB
+Thread* allocateThread(size_t maxStackSize) {
     Thread *thread = malloc(sizeof(Thread));
-    thread->stackLimit = malloc(stackSize);
-    thread->returned = false;
-    if (!thread->stackLimit) {
-        error("Could not allocate stack!");
+    if (!thread) {
+        error("Could not allocate thread!");
     }
-    thread->futureStack = thread->stack = thread->stackBottom = thread->stackLimit + stackSize - 1;
+    thread->returned = false;
+    thread->initializerFailed = false;
+    //The thread becomes running once it calls disallowGCAndPauseIfNeeded on its own OS thread
+    atomic_init(&thread->state, THREAD_SAFE);
+    stackInitialize(maxStackSize ? maxStackSize : defaultMaxStackSize, thread);
     
+    //A GC cycle holds the thread list mutex and waits for all threads to become safe
+    if (currentThread) allowGC();
     pthread_mutex_lock(&threadListMutex);
     thread->threadBefore = lastThread;
     thread->threadAfter = NULL;
@@ -32,21 +36,25 @@ Thread* allocateThread() {
     lastThread = thread;
     threads++;
     pthread_mutex_unlock(&threadListMutex);
+    if (currentThread) disallowGCAndPauseIfNeeded();
     
     return thread;
 }
 
 void removeThread(Thread *thread) {
+    //The thread must not hold up a GC cycle that is waiting for it while holding the thread list mutex
+    allowGC();
     pthread_mutex_lock(&threadListMutex);
     Thread *before = thread->threadBefore;
     Thread *after = thread->threadAfter;
     
     if (before) before->threadAfter = after;
     if (after) after->threadBefore = before;
+    if (lastThread == thread) lastThread = before;
     
     threads--;
     pthread_mutex_unlock(&threadListMutex);
     
-    free(thread->stackLimit);
+    stackFree(thread);
     free(thread);
 }
\ No newline at end of file
@@ -47,7 +47,7 @@ static Something systemExit(Thread *thread){
 }
 
 static Something systemGetEnv(Thread *thread){
-    char* variableName = stringToChar(stackGetVariable(0, thread).object->value);
+    char* variableName = stringToChar(objectValue(stackGetVariable(0, thread).object));
     char* env = getenv(variableName);
     
     if(!env)
@@ -74,13 +74,13 @@ static Something systemArgs(Thread *thread) {
     Object *listObject = newObject(CL_LIST);
     stackSetVariable(0, somethingObject(listObject), thread);
     
-    List *newList = listObject->value;
+    List *newList = objectValue(listObject);
     newList->capacity = cliArgumentCount;
-    Object *items = newArray(sizeof(Something) * cliArgumentCount);
+    Object *items = newListItems(cliArgumentCount);
     
     listObject = stackGetVariable(0, thread).object;
     
-    ((List *)listObject->value)->items = items;
+    ((List *)objectValue(listObject))->items = items;
     
     for (int i = 0; i < cliArgumentCount; i++) {
         listAppend(listObject, somethingObject(stringFromChar(cliArguments[i])), thread);
@@ -90,50 +90,135 @@ static Something systemArgs(Thread *thread) {
     return somethingObject(listObject);
 }
 
+//MARK: GC statistics
+
+static Something gcCollections(Thread *thread) {
+    return somethingInteger((EmojicodeInteger)gcStatistics().collections);
+}
+
+static Something gcTotalPause(Thread *thread) {
+    return somethingInteger((EmojicodeInteger)gcStatistics().totalPause);
+}
+
+static Something gcMaxPause(Thread *thread) {
+    return somethingInteger((EmojicodeInteger)gcStatistics().maxPause);
+}
+
+static Something gcPausePercentileBridge(Thread *thread) {
+    return somethingInteger((EmojicodeInteger)gcPausePercentile(stackGetVariable(0, thread).doubl));
+}
+
+static Something gcBytesAllocated(Thread *thread) {
+    return somethingInteger((EmojicodeInteger)gcStatistics().bytesAllocated);
+}
+
+static Something gcBytesCopied(Thread *thread) {
+    return somethingInteger((EmojicodeInteger)gcStatistics().bytesCopied);
+}
+
+static Something gcHeapHighWaterMark(Thread *thread) {
+    return somethingInteger((EmojicodeInteger)gcStatistics().heapHighWaterMark);
+}
+
+static Something gcCollect(Thread *thread) {
+    collectGarbageNow();
+    return NOTHINGNESS;
+}
+
+static int compareClassIndicesByName(const void *a, const void *b) {
+    EmojicodeChar x = classTable[*(const uint_fast16_t *)a]->name, y = classTable[*(const uint_fast16_t *)b]->name;
+    return x < y ? -1 : x > y;
+}
+
+static Something gcClassAllocations(Thread *thread) {
+    Object *dico = newObject(CL_DICTIONARY);
+    stackPush(somethingObject(dico), 0, 0, thread);
+    dictionaryInit(thread);
+    
+    //Classes in different namespaces may have the same name, so the class indices are grouped by name
+    uint_fast16_t *indices = malloc(classCount * sizeof(uint_fast16_t));
+    if (classCount && !indices) {
+        error("Could not allocate memory for the allocation statistics!");
+    }
+    for (uint_fast16_t i = 0; i < classCount; i++) {
+        indices[i] = i;
+    }
+    qsort(indices, classCount, sizeof(uint_fast16_t), compareClassIndicesByName);
+    
+    for (uint_fast16_t i = 0; i < classCount;) {
+        EmojicodeChar className = classTable[indices[i]]->name;
+        uint64_t allocations = 0;
+        for (; i < classCount && classTable[indices[i]]->name == className; i++) {
+            allocations += classTable[indices[i]]->allocations;
+        }
+        if (allocations) {
+            char name[5] = {0};
+            u8_wc_toutf8(name, className);
+            Object *key = stringFromChar(name);
+            dictionarySet(stackGetThisObject(thread), key, somethingInteger((EmojicodeInteger)allocations), thread);
+        }
+    }
+    free(indices);
+    
+    dico = stackGetThisObject(thread);
+    stackPop(thread);
+    return somethingObject(dico);
+}
+
+static Something gcHeapSnapshot(Thread *thread) {
+    char *path = stringToChar(objectValue(stackGetVariable(0, thread).object));
+    bool success = heapSnapshot(path);
+    free(path);
+    return success ? EMOJICODE_TRUE : EMOJICODE_FALSE;
+}
+
 static Something systemSystem(Thread *thread) {
-    char *command = stringToChar(stackGetVariable(0, thread).object->value);
+    char *command = stringToChar(objectValue(stackGetVariable(0, thread).object));
+    
+    //The command's output is collected in native memory, the GC may run until the command exits
+    allowGC();
     FILE *f = popen(command, "r");
     free(command);
     
     if (!f) {
+        disallowGCAndPauseIfNeeded();
         return NOTHINGNESS;
     }
     
-    size_t bufferUsedSize = 0;
-    int bufferSize = 50;
-    Object *buffer = newArray(bufferSize);
-    
-    while (fgets((char *)buffer->value + bufferUsedSize, bufferSize - (int)bufferUsedSize, f) != NULL) {
-        bufferUsedSize = strlen(buffer->value);
-        
+    size_t bufferUsedSize = 0, bufferSize = 64;
+    char *buffer = malloc(bufferSize);
+    size_t read;
+    while (buffer && (read = fread(buffer + bufferUsedSize, 1, bufferSize - bufferUsedSize - 1, f)) > 0) {
+        bufferUsedSize += read;
         if (bufferSize - bufferUsedSize < 2) {
             bufferSize *= 2;
-            buffer = resizeArray(buffer, bufferSize);
+            char *newBuffer = realloc(buffer, bufferSize);
+            if (!newBuffer) {
+                free(buffer);
+            }
+            buffer = newBuffer;
         }
     }
+    pclose(f);
+    disallowGCAndPauseIfNeeded();
     
-    bufferUsedSize = strlen(buffer->value);
-    
-    EmojicodeInteger len = u8_strlen_l(buffer->value, bufferUsedSize);
-    
-    Object *so = newObject(CL_STRING);
-    stackSetVariable(0, somethingObject(so), thread);
-    String *string = so->value;
-    string->length = len;
-    
-    Object *chars = newArray(len * sizeof(EmojicodeChar));
-    string = stackGetVariable(0, thread).object->value;
-    string->characters = chars;
-    
-    u8_toucs(characters(string), len, buffer->value, bufferUsedSize);
+    if (!buffer) {
+        error("Could not allocate buffer for command output!");
+    }
     
-    return stackGetVariable(0, thread);
+    buffer[bufferUsedSize] = 0;
+    Object *string = stringFromChar(buffer);
+    free(buffer);
+    return somethingObject(string);
 }
 
 //MARK: Threads
 
 void* threadStarter(void *threadv) {
     Thread *thread = threadv;
+    currentThread = thread;
+    disallowGCAndPauseIfNeeded();
+    stackSetNativeStackSize(thread->maxStackSize, thread);
     Object *callable = stackGetThisObject(thread);
     stackPop(thread);
     executeCallableExtern(callable, NULL, thread);
@@ -143,33 +228,60 @@ void* threadStarter(void *threadv) {
 
 static Something threadJoin(Thread *thread) {
     allowGC();
-    bool l = pthread_join(*(pthread_t *)((Object *)stackGetThisObject(thread))->value, NULL) == 0;
+    bool l = pthread_join(*(pthread_t *)objectValue(stackGetThisObject(thread)), NULL) == 0;
     disallowGCAndPauseIfNeeded();
     return l ? EMOJICODE_TRUE : EMOJICODE_FALSE;
 }
 
 static Something threadSleep(Thread *thread){
-    sleep((unsigned int)stackGetVariable(0, thread).raw);
+    unsigned int seconds = (unsigned int)stackGetVariable(0, thread).raw;
+    allowGC();
+    sleep(seconds);
+    disallowGCAndPauseIfNeeded();
     return NOTHINGNESS;
 }
 
 static Something threadSleepMicroseconds(Thread *thread){
-    usleep((unsigned int)stackGetVariable(0, thread).raw);
+    unsigned int microseconds = (unsigned int)stackGetVariable(0, thread).raw;
+    allowGC();
+    usleep(microseconds);
+    disallowGCAndPauseIfNeeded();
     return NOTHINGNESS;
 }
 
-static void initThread(Thread *thread) {
-    Thread *t = allocateThread();
+/** Threads are given at least this much stack space. */
+#define minimalThreadStackSize (256 * 1024)
+
+/** Starts a thread whose VM stack and native stack may both grow up to @c stackSize bytes. */
+static void startThread(Thread *thread, size_t stackSize) {
+    if (stackSize < minimalThreadStackSize) {
+        stackSize = minimalThreadStackSize;
+    }
+    Thread *t = allocateThread(stackSize);
     stackPush(stackGetVariable(0, thread), 0, 0, t);
-    pthread_create((pthread_t *)((Object *)stackGetThisObject(thread))->value, NULL, threadStarter, t);
+    
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setstacksize(&attributes, stackSize);
+    pthread_create((pthread_t *)objectValue(stackGetThisObject(thread)), &attributes, threadStarter, t);
+    pthread_attr_destroy(&attributes);
+}
+
+static void initThread(Thread *thread) {
+    startThread(thread, defaultMaxStackSize);
+}
+
+static void initThreadStackSize(Thread *thread) {
+    EmojicodeInteger stackSize = unwrapInteger(stackGetVariable(1, thread));
+    startThread(thread, stackSize > 0 ? (size_t)stackSize : 0);
 }
 
 static void initMutex(Thread *thread) {
-    pthread_mutex_init(((Object *)stackGetThisObject(thread))->value, NULL);
+    pthread_mutex_init(objectValue(stackGetThisObject(thread)), NULL);
 }
 
 static Something mutexLock(Thread *thread) {
-    while (pthread_mutex_trylock(((Object *)stackGetThisObject(thread))->value) != 0) {
+    while (pthread_mutex_trylock(objectValue(stackGetThisObject(thread))) != 0) {
         //TODO: Obviously stupid, but this is the only safe way. If pthread_mutex_lock was used,
         //the thread would be block, and the GC could cause a deadlock. allowGC, however, would
         //allow moving this mutex – obviously not a good idea either when using pthread_mutex_lock.
@@ -180,12 +292,214 @@ static Something mutexLock(Thread *thread) {
 }
 
 static Something mutexUnlock(Thread *thread) {
-    pthread_mutex_unlock(((Object *)stackGetThisObject(thread))->value);
+    pthread_mutex_unlock(objectValue(stackGetThisObject(thread)));
     return NOTHINGNESS;
 }
 
 static Something mutexTryLock(Thread *thread) {
-    return pthread_mutex_trylock(((Object *)stackGetThisObject(thread))->value) == 0 ? EMOJICODE_TRUE : EMOJICODE_FALSE;
+    return pthread_mutex_trylock(objectValue(stackGetThisObject(thread))) == 0 ? EMOJICODE_TRUE : EMOJICODE_FALSE;
+}
+
+//MARK: Futures
+
+/**
+ * The state of a 📬. It is allocated outside the heap so that the mutex and the condition variable are not moved
+ * while threads wait on them.
+ */
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t completion;
+    bool completed;
+    /** The value the future was completed with. Never changed once @c completed is set. */
+    Something value;
+    /** Pairs of a 🏊 and a callable to submit to it once the future is completed. */
+    Object **continuations;
+    size_t continuationsCount;
+    size_t continuationsCapacity;
+} Future;
+
+static void initFuture(Thread *thread) {
+    Future *future = calloc(1, sizeof(Future));
+    if (!future) {
+        error("Could not allocate future!");
+    }
+    pthread_mutex_init(&future->mutex, NULL);
+    pthread_cond_init(&future->completion, NULL);
+    future->value = NOTHINGNESS;
+    *(Future **)objectValue(stackGetThisObject(thread)) = future;
+}
+
+static Something futureComplete(Thread *thread) {
+    Future *future = *(Future **)objectValue(stackGetThisObject(thread));
+    pthread_mutex_lock(&future->mutex);
+    if (future->completed) {
+        pthread_mutex_unlock(&future->mutex);
+        return EMOJICODE_FALSE;
+    }
+    future->value = stackGetVariable(0, thread);
+    future->completed = true;
+    Object **continuations = future->continuations;
+    size_t continuationsCount = future->continuationsCount;
+    for (size_t i = 0; i < continuationsCount * 2; i++) {
+        writeBarrier(continuations[i]);
+    }
+    future->continuations = NULL;
+    future->continuationsCount = future->continuationsCapacity = 0;
+    pthread_cond_broadcast(&future->completion);
+    pthread_mutex_unlock(&future->mutex);
+    
+    //Submitting does not allocate objects, so the GC cannot run before all continuations are queued
+    for (size_t i = 0; i < continuationsCount; i++) {
+        taskPoolSubmitCallable(continuations[i * 2], continuations[i * 2 + 1]);
+    }
+    free(continuations);
+    return EMOJICODE_TRUE;
+}
+
+static Something futureAwait(Thread *thread) {
+    Future *future = *(Future **)objectValue(stackGetThisObject(thread));
+    allowGC();
+    pthread_mutex_lock(&future->mutex);
+    while (!future->completed) {
+        pthread_cond_wait(&future->completion, &future->mutex);
+    }
+    pthread_mutex_unlock(&future->mutex);
+    disallowGCAndPauseIfNeeded();
+    //The value may have been moved by the GC while this thread was waiting
+    return future->value;
+}
+
+static Something futureIsCompleted(Thread *thread) {
+    Future *future = *(Future **)objectValue(stackGetThisObject(thread));
+    pthread_mutex_lock(&future->mutex);
+    bool completed = future->completed;
+    pthread_mutex_unlock(&future->mutex);
+    return completed ? EMOJICODE_TRUE : EMOJICODE_FALSE;
+}
+
+static Something futureSchedule(Thread *thread) {
+    Future *future = *(Future **)objectValue(stackGetThisObject(thread));
+    Object *pool = stackGetVariable(0, thread).object;
+    Object *callable = stackGetVariable(1, thread).object;
+    
+    pthread_mutex_lock(&future->mutex);
+    if (!future->completed) {
+        if (future->continuationsCount == future->continuationsCapacity) {
+            size_t capacity = future->continuationsCapacity ? future->continuationsCapacity * 2 : 4;
+            Object **continuations = realloc(future->continuations, capacity * 2 * sizeof(Object *));
+            if (!continuations) {
+                pthread_mutex_unlock(&future->mutex);
+                error("Could not allocate future continuations!");
+            }
+            future->continuations = continuations;
+            future->continuationsCapacity = capacity;
+        }
+        future->continuations[future->continuationsCount * 2] = pool;
+        future->continuations[future->continuationsCount * 2 + 1] = callable;
+        future->continuationsCount++;
+        pthread_mutex_unlock(&future->mutex);
+        return NOTHINGNESS;
+    }
+    pthread_mutex_unlock(&future->mutex);
+    taskPoolSubmitCallable(pool, callable);
+    return NOTHINGNESS;
+}
+
+static void futureMark(Object *o) {
+    Future *future = *(Future **)objectValue(o);
+    if (!future) {
+        return;
+    }
+    if (isRealObject(future->value)) {
+        mark(&future->value.object);
+    }
+    for (size_t i = 0; i < future->continuationsCount * 2; i++) {
+        mark(&future->continuations[i]);
+    }
+}
+
+static void futureDeinitialize(void *value) {
+    Future *future = *(Future **)value;
+    pthread_mutex_destroy(&future->mutex);
+    pthread_cond_destroy(&future->completion);
+    free(future->continuations);
+    free(future);
+}
+
+//MARK: Atomics
+
+/**
+ * The values of 🔢 and 📎 are stored in the objects. The GC only moves objects while all threads are stopped, which
+ * never happens during one of the operations below, so the atomic operations themselves are not disturbed by it.
+ */
+#define atomicInteger(thread) ((_Atomic EmojicodeInteger *)objectValue(stackGetThisObject(thread)))
+#define atomicReference(thread) ((_Atomic(Object *) *)objectValue(stackGetThisObject(thread)))
+
+static void initAtomicInteger(Thread *thread) {
+    atomic_init(atomicInteger(thread), unwrapInteger(stackGetVariable(0, thread)));
+}
+
+static Something atomicIntegerLoad(Thread *thread) {
+    return somethingInteger(atomic_load(atomicInteger(thread)));
+}
+
+static Something atomicIntegerStore(Thread *thread) {
+    atomic_store(atomicInteger(thread), unwrapInteger(stackGetVariable(0, thread)));
+    return NOTHINGNESS;
+}
+
+static Something atomicIntegerFetchAdd(Thread *thread) {
+    return somethingInteger(atomic_fetch_add(atomicInteger(thread), unwrapInteger(stackGetVariable(0, thread))));
+}
+
+static Something atomicIntegerExchange(Thread *thread) {
+    return somethingInteger(atomic_exchange(atomicInteger(thread), unwrapInteger(stackGetVariable(0, thread))));
+}
+
+static Something atomicIntegerCompareExchange(Thread *thread) {
+    EmojicodeInteger expected = unwrapInteger(stackGetVariable(0, thread));
+    bool exchanged = atomic_compare_exchange_strong(atomicInteger(thread), &expected,
+                                                    unwrapInteger(stackGetVariable(1, thread)));
+    return exchanged ? EMOJICODE_TRUE : EMOJICODE_FALSE;
+}
+
+static void initAtomicReference(Thread *thread) {
+    atomic_init(atomicReference(thread), stackGetVariable(0, thread).object);
+}
+
+static Something atomicReferenceLoad(Thread *thread) {
+    return somethingObject(atomic_load(atomicReference(thread)));
+}
+
+static Something atomicReferenceStore(Thread *thread) {
+    writeBarrier(atomic_exchange(atomicReference(thread), stackGetVariable(0, thread).object));
+    return NOTHINGNESS;
+}
+
+static Something atomicReferenceExchange(Thread *thread) {
+    Object *old = atomic_exchange(atomicReference(thread), stackGetVariable(0, thread).object);
+    writeBarrier(old);
+    return somethingObject(old);
+}
+
+/** Compares identity. Both references were updated by the same GC cycle if the objects were moved. */
+static Something atomicReferenceCompareExchange(Thread *thread) {
+    Object *expected = stackGetVariable(0, thread).object;
+    bool exchanged = atomic_compare_exchange_strong(atomicReference(thread), &expected,
+                                                    stackGetVariable(1, thread).object);
+    if (exchanged) {
+        writeBarrier(expected);
+    }
+    return exchanged ? EMOJICODE_TRUE : EMOJICODE_FALSE;
+}
+
+static void atomicReferenceMark(Object *o) {
+    _Atomic(Object *) *reference = objectValue(o);
+    Object *object = atomic_load_explicit(reference, memory_order_relaxed);
+    if (object) {
+        mark(&object);
+        atomic_store_explicit(reference, object, memory_order_relaxed);
+    }
 }
 
 //MARK: Error
@@ -193,7 +507,7 @@ static Something mutexTryLock(Thread *thread) {
 Object* newError(const char *message, int code){
     Object *o = newObject(CL_ERROR);
     
-    EmojicodeError* error = o->value;
+    EmojicodeError* error = objectValue(o);
     error->message = message;
     error->code = code;
     
@@ -201,18 +515,18 @@ Object* newError(const char *message, int code){
 }
 
 void newErrorBridge(Thread *thread){
-    EmojicodeError *error = stackGetThisObject(thread)->value;
-    error->message = stringToChar(stackGetVariable(0, thread).object->value);
+    EmojicodeError *error = objectValue(stackGetThisObject(thread));
+    error->message = stringToChar(objectValue(stackGetVariable(0, thread).object));
     error->code = unwrapInteger(stackGetVariable(1, thread));
 }
 
 static Something errorGetMessage(Thread *thread){
-    EmojicodeError *error = stackGetThisObject(thread)->value;
+    EmojicodeError *error = objectValue(stackGetThisObject(thread));
     return somethingObject(stringFromChar(error->message));
 }
 
 static Something errorGetCode(Thread *thread){
-    EmojicodeError *error = stackGetThisObject(thread)->value;
+    EmojicodeError *error = objectValue(stackGetThisObject(thread));
     return somethingInteger((EmojicodeInteger)error->code);
 }
 
@@ -223,14 +537,14 @@ void rangeSetDefaultStep(EmojicodeRange *range) {
 }
 
 static void initRangeStartStop(Thread *thread) {
-    EmojicodeRange *range = stackGetThisObject(thread)->value;
+    EmojicodeRange *range = objectValue(stackGetThisObject(thread));
     range->start = stackGetVariable(0, thread).raw;
     range->stop = stackGetVariable(1, thread).raw;
     rangeSetDefaultStep(range);
 }
 
 static void initRangeStartStopStep(Thread *thread) {
-    EmojicodeRange *range = stackGetThisObject(thread)->value;
+    EmojicodeRange *range = objectValue(stackGetThisObject(thread));
     range->start = stackGetVariable(0, thread).raw;
     range->stop = stackGetVariable(1, thread).raw;
     range->step = stackGetVariable(2, thread).raw;
@@ -238,7 +552,7 @@ static void initRangeStartStopStep(Thread *thread) {
 }
 
 static Something rangeGet(Thread *thread) {
-    EmojicodeRange *range = stackGetThisObject(thread)->value;
+    EmojicodeRange *range = objectValue(stackGetThisObject(thread));
     EmojicodeInteger h = range->start + stackGetVariable(0, thread).raw * range->step;
     return (range->step > 0 ? range->start <= h && h < range->stop : range->stop < h && h <= range->start) ? somethingInteger(h) : NOTHINGNESS;
 }
@@ -246,8 +560,8 @@ static Something rangeGet(Thread *thread) {
 //MARK: Data
 
 static Something dataEqual(Thread *thread) {
-    Data *d = stackGetThisObject(thread)->value;
-    Data *b = stackGetVariable(0, thread).object->value;
+    Data *d = objectValue(stackGetThisObject(thread));
+    Data *b = objectValue(stackGetVariable(0, thread).object);
     
     if(d->length != b->length){
         return EMOJICODE_FALSE;
@@ -257,20 +571,51 @@ static Something dataEqual(Thread *thread) {
 }
 
 static Something dataSize(Thread *thread) {
-    Data *d = stackGetThisObject(thread)->value;
+    Data *d = objectValue(stackGetThisObject(thread));
     return somethingInteger((EmojicodeInteger)d->length);
 }
 
 static void dataMark(Object *o) {
-    Data *d = o->value;
+    Data *d = objectValue(o);
     if (d->bytesObject) {
+        //A slice’s bytes start somewhere within the array
+        ptrdiff_t offset = d->bytes - (char *)objectValue(d->bytesObject);
         mark(&d->bytesObject);
-        d->bytes = d->bytesObject->value;
+        if (d->bytesObject->class == CL_ARRAY) {
+            d->bytes = (char *)objectValue(d->bytesObject) + offset;
+        }
     }
 }
 
+static void dataBufferDeinitialize(void *value) {
+    free(*(char **)value);
+}
+
+static Class clDataBuffer = {
+    .deconstruct = dataBufferDeinitialize,
+    .size = sizeof(char *),
+    .valueSize = sizeof(char *),
+};
+Class *CL_DATA_BUFFER = &clDataBuffer;
+
+Object* newOffHeapData(char *bytes, EmojicodeInteger length) {
+    Thread *thread = currentThread;
+    registerExternalAllocation(length);
+    Object *buffer = newObject(CL_DATA_BUFFER);
+    *(char **)objectValue(buffer) = bytes;
+    
+    stackPush(somethingObject(buffer), 0, 0, thread);
+    Object *obj = newObject(CL_DATA);
+    Data *data = objectValue(obj);
+    data->length = length;
+    data->bytes = bytes;
+    data->bytesObject = stackGetThisObject(thread);
+    stackPop(thread);
+    return obj;
+}
+
 static Something dataGetByte(Thread *thread) {
-    Data *d = stackGetThisObject(thread)->value;
+    Data *d = objectValue(stackGetThisObject(thread));
     
     EmojicodeInteger index = unwrapInteger(stackGetVariable(0, thread));
     if (index < 0) {
@@ -284,7 +629,7 @@ static Something dataGetByte(Thread *thread) {
 }
 
 static Something dataToString(Thread *thread) {
-    Data *data = stackGetThisObject(thread)->value;
+    Data *data = objectValue(stackGetThisObject(thread));
     if (!u8_isvalid(data->bytes, data->length)) {
         return NOTHINGNESS;
     }
@@ -294,18 +639,19 @@ static Something dataToString(Thread *thread) {
     
     stackPush(somethingObject(characters), 0, 0, thread);
     Object *sto = newObject(CL_STRING);
-    String *string = sto->value;
+    String *string = objectValue(sto);
     string->length = len;
     string->characters = stackGetThisObject(thread);
     stackPop(thread);
+    data = objectValue(stackGetThisObject(thread));
     u8_toucs(characters(string), len, data->bytes, data->length);
     return somethingObject(sto);
 }
 
 static Something dataSlice(Thread *thread) {
     Object *ooData = newObject(CL_DATA);
-    Data *oData = ooData->value;
-    Data *data = stackGetThisObject(thread)->value;
+    Data *oData = objectValue(ooData);
+    Data *data = objectValue(stackGetThisObject(thread));
     
     EmojicodeInteger from = stackGetVariable(0, thread).raw;
     if (from >= data->length) {
@@ -324,8 +670,8 @@ static Something dataSlice(Thread *thread) {
 }
 
 static Something dataIndexOf(Thread *thread) {
-    Data *data = stackGetThisObject(thread)->value;
-    Data *search = stackGetVariable(0, thread).object->value;
+    Data *data = objectValue(stackGetThisObject(thread));
+    Data *search = objectValue(stackGetVariable(0, thread).object);
     void *location = findBytesInBytes(data->bytes, data->length, search->bytes, search->length);
     if (!location) {
         return NOTHINGNESS;
@@ -336,23 +682,23 @@ static Something dataIndexOf(Thread *thread) {
 }
 
 static Something dataByAppendingData(Thread *thread) {
-    Data *data = stackGetThisObject(thread)->value;
-    Data *b = stackGetVariable(0, thread).object->value;
+    Data *data = objectValue(stackGetThisObject(thread));
+    Data *b = objectValue(stackGetVariable(0, thread).object);
     
     size_t size = data->length + b->length;
     Object *newBytes = newArray(size);
     
-    b = stackGetVariable(0, thread).object->value;
-    data = stackGetThisObject(thread)->value;
+    b = objectValue(stackGetVariable(0, thread).object);
+    data = objectValue(stackGetThisObject(thread));
     
-    memcpy(newBytes->value, data->bytes, data->length);
-    memcpy((Byte *)newBytes->value + data->length, b->bytes, b->length);
+    memcpy(objectValue(newBytes), data->bytes, data->length);
+    memcpy((Byte *)objectValue(newBytes) + data->length, b->bytes, b->length);
     
     stackSetVariable(0, somethingObject(newBytes), thread);
     Object *ooData = newObject(CL_DATA);
-    Data *oData = ooData->value;
+    Data *oData = objectValue(ooData);
     oData->bytesObject = stackGetVariable(0, thread).object;
-    oData->bytes = oData->bytesObject->value;
+    oData->bytes = objectValue(oData->bytesObject);
     oData->length = size;
     return somethingObject(ooData);
 }
@@ -361,26 +707,18 @@ static Something dataByAppendingData(Thread *thread) {
 
 Something integerToString(Thread *thread) {
     EmojicodeInteger base = stackGetVariable(0, thread).raw;
-    EmojicodeInteger n = stackGetThisContext(thread).raw, a = llabs(n);
-    bool negative = n < 0;
-    
-    EmojicodeInteger d = negative ? 2 : 1;
-    while (n /= base) d++;
+    EmojicodeInteger n = stackGetThisContext(thread).raw;
+    EmojicodeInteger d = integerStringLength(n, base);
     
     Object *co = newArray(d * sizeof(EmojicodeChar));
     stackSetVariable(0, somethingObject(co), thread);
     
     Object *stringObject = newObject(CL_STRING);
-    String *string = stringObject->value;
+    String *string = objectValue(stringObject);
     string->length = d;
     string->characters = stackGetVariable(0, thread).object;
     
-    EmojicodeChar *characters = characters(string) + d;
-    do
-        *--characters =  "0123456789abcdefghijklmnopqrstuvxyz"[a % base % 35];
-    while (a /= base);
-    
-    if (negative) characters[-1] = '-';
+    integerWriteString(n, base, d, characters(string));
     
     return somethingObject(stringObject);
 }
@@ -399,11 +737,11 @@ static Something symbolToString(Thread *thread){
     Object *co = newArray(sizeof(EmojicodeChar));
     stackPush(somethingObject(co), 0, 0, thread);
     Object *stringObject = newObject(CL_STRING);
-    String *string = stringObject->value;
+    String *string = objectValue(stringObject);
     string->length = 1;
     string->characters = stackGetThisObject(thread);
     stackPop(thread);
-    ((EmojicodeChar *)string->characters->value)[0] = (EmojicodeChar)stackGetThisContext(thread).raw;
+    ((EmojicodeChar *)objectValue(string->characters))[0] = (EmojicodeChar)stackGetThisContext(thread).raw;
     return somethingObject(stringObject);
 }
 
@@ -432,7 +770,7 @@ static Something doubleToString(Thread *thread) {
     Object *co = newArray(length * sizeof(EmojicodeChar));
     stackSetVariable(0, somethingObject(co), thread);
     Object *stringObject = newObject(CL_STRING);
-    String *string = stringObject->value;
+    String *string = objectValue(stringObject);
     string->length = length;
     string->characters = stackGetVariable(0, thread).object;
     
@@ -513,15 +851,15 @@ static Something doubleAbsolute(Thread *thread) {
 // MARK: Callable
 
 static void closureMark(Object *o){
-    Closure *c = o->value;
+    Closure *c = objectValue(o);
     if (isRealObject(c->thisContext)) {
         mark(&c->thisContext.object);
     }
     mark(&c->capturedVariables);
     
-    Something *t = c->capturedVariables->value;
+    Something *t = objectValue(c->capturedVariables);
     for (uint8_t i = 0; i < c->capturedVariablesCount; i++) {
-        Something *s = t + c->argumentCount + i;
+        Something *s = t + i;
         if (isRealObject(*s)) {
             mark(&s->object);
         }
@@ -529,7 +867,7 @@ static void closureMark(Object *o){
 }
 
 static void capturedMethodMark(Object *o){
-    CapturedFunctionCall *c = o->value;
+    CapturedFunctionCall *c = objectValue(o);
     if (isRealObject(c->callee)) {
         mark(&c->callee.object);
     }
@@ -582,6 +920,56 @@ FunctionFunctionPointer handlerPointerForMethod(EmojicodeChar cl, EmojicodeChar
                 case 0x1f6c2: //🛂
                     return threadJoin;
             }
+        case 0x1f4ec: //📬
+            switch (symbol) {
+                case 0x1f4e9: //📩
+                    return futureComplete;
+                case 0x1f6c2: //🛂
+                    return futureAwait;
+                case 0x2705: //✅
+                    return futureIsCompleted;
+                case 0x1f4c6: //📆
+                    return futureSchedule;
+            }
+            return NULL;
+        case 0x1f4e1: //📡
+            return channelMethodForName(symbol);
+        case 0x1f300: //🌀
+            return coroutineMethodForName(symbol);
+        case 0x1f6a6: //🚦
+        case 0x1f514: //🔔
+        case 0x1f6a5: //🚥
+            return synchronizationMethodForName(cl, symbol);
+        case 0x1f522: //🔢
+            switch (symbol) {
+                case 0x1f440: //👀
+                    return atomicIntegerLoad;
+                case 0x1f4dd: //📝
+                    return atomicIntegerStore;
+                case 0x2795: //➕
+                    return atomicIntegerFetchAdd;
+                case 0x1f500: //🔀
+                    return atomicIntegerExchange;
+                case 0x1f504: //🔄
+                    return atomicIntegerCompareExchange;
+            }
+            return NULL;
+        case 0x1f4ce: //📎
+            switch (symbol) {
+                case 0x1f440: //👀
+                    return atomicReferenceLoad;
+                case 0x1f4dd: //📝
+                    return atomicReferenceStore;
+                case 0x1f500: //🔀
+                    return atomicReferenceExchange;
+                case 0x1f504: //🔄
+                    return atomicReferenceCompareExchange;
+            }
+            return NULL;
+        case 0x1f3ca: //🏊
+            return taskPoolMethodForName(symbol);
+        case 0x1f3ab: //🎫
+            return taskMethodForName(symbol);
         case 0x1f510: //🔐
             switch (symbol) {
                 case 0x1f512: //🔒
@@ -655,6 +1043,29 @@ FunctionFunctionPointer handlerPointerForMethod(EmojicodeChar cl, EmojicodeChar
                 case 0x1f574: //🕴
                     return systemSystem;
             }
+        case 0x1f5d1: //🗑
+            switch (symbol) {
+                case 0x1f501: //🔁
+                    return gcCollections;
+                case 0x23f1: //⏱
+                    return gcTotalPause;
+                case 0x1f3d4: //🏔
+                    return gcMaxPause;
+                case 0x1f4c8: //📈
+                    return gcPausePercentileBridge;
+                case 0x1f4e5: //📥
+                    return gcBytesAllocated;
+                case 0x1f4cb: //📋
+                    return gcBytesCopied;
+                case 0x1f30a: //🌊
+                    return gcHeapHighWaterMark;
+                case 0x1f4ca: //📊
+                    return gcClassAllocations;
+                case 0x1f4f8: //📸
+                    return gcHeapSnapshot;
+                case 0x1f6ae: //🚮
+                    return gcCollect;
+            }
     }
     return NULL;
 }
@@ -672,9 +1083,32 @@ InitializerFunctionFunctionPointer handlerPointerForInitializer(EmojicodeChar cl
         case 0x1F36F: //Only dictionary contstructor 0x1F438
             return bridgeDictionaryInit;
         case 0x1f488: //💈
-            return initThread;
+            switch (symbol) {
+                case 0x1f4cf: //📏
+                    return initThreadStackSize;
+                default:
+                    return initThread;
+            }
         case 0x1f510: //🔐
             return initMutex;
+        case 0x1f4ec: //📬
+            return initFuture;
+        case 0x1f4e1: //📡
+            return channelInitializerForName(symbol);
+        case 0x1f300: //🌀
+            return coroutineInitializerForName(symbol);
+        case 0x1f6a6: //🚦
+        case 0x1f514: //🔔
+        case 0x1f6a5: //🚥
+            return synchronizationInitializerForName(cl);
+        case 0x1f522: //🔢
+            return initAtomicInteger;
+        case 0x1f4ce: //📎
+            return initAtomicReference;
+        case 0x1f3ca: //🏊
+            return taskPoolInitializerForName(symbol);
+        case 0x1f3ab: //🎫
+            return taskInitializerForName(symbol);
         case 0x23E9:
             switch (symbol) {
                 case 0x23E9:
@@ -706,6 +1140,24 @@ uint_fast32_t sizeForClass(Class *cl, EmojicodeChar name) {
             return sizeof(pthread_t);
         case 0x1f510: //🔐
             return sizeof(pthread_mutex_t);
+        case 0x1f3ca: //🏊
+            return sizeof(TaskPool *);
+        case 0x1f4ec: //📬
+            return sizeof(Future *);
+        case 0x1f4e1: //📡
+            return sizeof(Channel *);
+        case 0x1f300: //🌀
+            return sizeof(Coroutine *);
+        case 0x1f6a6: //🚦
+        case 0x1f514: //🔔
+        case 0x1f6a5: //🚥
+            return sizeof(void *);
+        case 0x1f522: //🔢
+            return sizeof(_Atomic EmojicodeInteger);
+        case 0x1f4ce: //📎
+            return sizeof(_Atomic(Object *));
+        case 0x1f3ab: //🎫
+            return sizeof(Task);
     }
     return 0;
 }
@@ -724,10 +1176,32 @@ Marker markerPointerForClass(EmojicodeChar cl){
             return capturedMethodMark;
         case 0x1F4C7:
             return dataMark;
+        case 0x1f3ab: //🎫
+            return taskMark;
+        case 0x1f4ec: //📬
+            return futureMark;
+        case 0x1f4e1: //📡
+            return channelMark;
+        case 0x1f4ce: //📎
+            return atomicReferenceMark;
     }
     return NULL;
 }
 
 Deinitializer deinitializerPointerForClass(EmojicodeChar cl){
+    switch (cl) {
+        case 0x1f3ca: //🏊
+            return taskPoolDeinitialize;
+        case 0x1f4ec: //📬
+            return futureDeinitialize;
+        case 0x1f4e1: //📡
+            return channelDeinitialize;
+        case 0x1f300: //🌀
+            return coroutineDeinitialize;
+        case 0x1f6a6: //🚦
+        case 0x1f514: //🔔
+        case 0x1f6a5: //🚥
+            return synchronizationDeinitialize;
+    }
     return NULL;
 }
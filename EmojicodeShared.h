@@ -28,7 +28,22 @@ typedef uint32_t EmojicodeCoin;
 #define defaultPackagesDirectory "/usr/local/EmojicodePackages"
 #endif
 extern const char *packageDirectory;
-#define ByteCodeSpecificationVersion 5
+#define ByteCodeSpecificationVersion 8
+
+/**
+ * How an instance variable is stored in an object. The compiler chooses the kind from the variable’s static type
+ * and passes it to the instance variable commands together with the variable’s offset.
+ */
+/** A full @c Something, which is 16 bytes. */
+#define IV_SOMETHING 0
+/** A reference to an object that is never Nothingness once initialized, which is 8 bytes. */
+#define IV_OBJECT 1
+/** An 8-byte integer. */
+#define IV_INTEGER 2
+/** An 8-byte double. */
+#define IV_DOUBLE 3
+/** A 1-byte boolean. */
+#define IV_BOOLEAN 4
 
 /**
  * @defined(isWhitespace)
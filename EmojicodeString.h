@@ -14,7 +14,7 @@
 
 extern Object **stringPool;
 #define emptyString (stringPool[0])
-#define characters(string) ((EmojicodeChar*)(string)->characters->value)
+#define characters(string) ((EmojicodeChar*)objectValue((string)->characters))
 
 /** Compares if the value of @c a is equal to @c b. */
 bool stringEqual(String *a, String *b);
@@ -25,7 +25,7 @@ bool stringEqual(String *a, String *b);
  */
 char* stringToChar(String *str);
 
-/** Creates a string from a UTF8 C string. The string must be null terminated! */
+/** Creates a string from a UTF8 C string. The string must be null terminated! This function may invoke the GC. */
 Object* stringFromChar(const char *cstring);
 
 /** 
@@ -34,6 +34,13 @@ Object* stringFromChar(const char *cstring);
  */
 Something parseJSON(Thread *thread);
 
+/** Returns the number of characters needed to represent @c n in @c base. */
+EmojicodeInteger integerStringLength(EmojicodeInteger n, EmojicodeInteger base);
+
+/** Writes the representation of @c n in @c base, which is @c length characters long, to @c characters. */
+void integerWriteString(EmojicodeInteger n, EmojicodeInteger base, EmojicodeInteger length,
+                        EmojicodeChar *characters);
+
 void stringMark(Object *self);
 
 void initStringFromSymbolList(Object *string, List *list);
@@ -21,8 +21,9 @@ echo "${b}Copying builds to /usr/local/bin/${n}"
 
 cp emojicode /usr/local/bin/emojicode
 cp emojicodec /usr/local/bin/emojicodec
+cp emojicodeheap /usr/local/bin/emojicodeheap
 
-chmod 755 /usr/local/bin/emojicode /usr/local/bin/emojicodec
+chmod 755 /usr/local/bin/emojicode /usr/local/bin/emojicodec /usr/local/bin/emojicodeheap
 
 echo "${b}Setting up packages directory in /usr/local/EmojicodePackages${n}"
 
@@ -0,0 +1,94 @@
+//
+//  pinning.c
+//  Packages
+//
+//  Tests the pinning API, which is not reachable from Emojicode code otherwise.
+//
+
+#include "EmojicodeReal-TimeEngine/Emojicode.h"
+
+PackageVersion getVersion(){
+    return (PackageVersion){0, 1};
+}
+
+#define pinnedArray(obj) (*((Object**)objectValue(obj)))
+
+/** The byte the array of a 📌 is expected to hold at @c index. */
+#define patternByte(index) ((char)((index) * 7))
+
+void pinningNew(Thread *thread){
+    size_t size = (size_t)unwrapInteger(stackGetVariable(0, thread));
+    Object *array = newPinnedArray(size);
+    char *bytes = objectValue(array);
+    for (size_t i = 0; i < size; i++) {
+        bytes[i] = patternByte(i);
+    }
+    pinnedArray(stackGetThisObject(thread)) = array;
+}
+
+Something pinningPin(Thread *thread){
+    return pinArray(pinnedArray(stackGetThisObject(thread))) ? EMOJICODE_TRUE : EMOJICODE_FALSE;
+}
+
+Something pinningUnpin(Thread *thread){
+    unpinArray(pinnedArray(stackGetThisObject(thread)));
+    return NOTHINGNESS;
+}
+
+Something pinningAddress(Thread *thread){
+    return somethingInteger((EmojicodeInteger)(uintptr_t)objectValue(pinnedArray(stackGetThisObject(thread))));
+}
+
+Something pinningIntact(Thread *thread){
+    Object *array = pinnedArray(stackGetThisObject(thread));
+    size_t size = (size_t)unwrapInteger(stackGetVariable(0, thread));
+    char *bytes = objectValue(array);
+    for (size_t i = 0; i < size; i++) {
+        if (bytes[i] != patternByte(i)) {
+            return EMOJICODE_FALSE;
+        }
+    }
+    return EMOJICODE_TRUE;
+}
+
+Something pinningLargeObjectSpaceSize(Thread *thread){
+    return somethingInteger((EmojicodeInteger)gcStatistics().largeObjectSpaceSize);
+}
+
+Something pinningPinHeapArray(Thread *thread){
+    return pinArray(newArray(16)) ? EMOJICODE_TRUE : EMOJICODE_FALSE;
+}
+
+FunctionFunctionPointer handlerPointerForMethod(EmojicodeChar cl, EmojicodeChar symbol, MethodType t) {
+    switch (symbol) {
+        case 0x1F4CC: //📌
+            return pinningPin;
+        case 0x1F513: //🔓
+            return pinningUnpin;
+        case 0x1F4CD: //📍
+            return pinningAddress;
+        case 0x1F61B: //😛
+            return pinningIntact;
+        case 0x1F418: //🐘
+            return pinningLargeObjectSpaceSize;
+        case 0x1F41A: //🐚
+            return pinningPinHeapArray;
+    }
+    return NULL;
+}
+
+InitializerFunctionFunctionPointer handlerPointerForInitializer(EmojicodeChar cl, EmojicodeChar symbol){
+    return pinningNew;
+}
+
+Marker markerPointerForClass(EmojicodeChar cl){
+    return NULL;
+}
+
+uint_fast32_t sizeForClass(Class *cl, EmojicodeChar name) {
+    return sizeof(Object *);
+}
+
+Deinitializer deinitializerPointerForClass(EmojicodeChar cl){
+    return NULL;
+}